@@ -0,0 +1,136 @@
+//bitset.c
+/**
+ * This file (bitset.c) is an implementation of a set of integers from 0 to n - 1 stored as an array of bits.
+ * Toggling a member is a single xor on one word, so the parity of every word in a text can be kept with no hashing.
+ * The words are allocated in whole 16 byte blocks so countBits and xorBitset can work on two words at a time with SIMD instructions.
+ *
+ * @author Max Blennemann
+ * @version 10/18/26
+ */
+
+#include "bitset.h"
+#include <stdlib.h>
+#include <assert.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#define WORD_BITS 64 // Number of bits in each word of the array
+
+typedef struct bitset {
+    uint64_t* words; // Bit i is bit i % 64 of words[i / 64]
+    uint32_t numBits; // Number of bits the set was created to hold
+    uint32_t numWords; // Number of words allocated, always even
+} bitArray;
+
+/**
+ * Returns a new set that can hold the integers from 0 to numBits - 1, with every bit clear.
+ *
+ * @param numBits the number of bits
+ * @return the newly allocated set
+ * @timeComplexity O(n) Where n is numBits / 64
+ */
+BITSET* createBitset(uint32_t numBits) {
+    bitArray* a = malloc(sizeof(bitArray));
+    assert(a != NULL);
+    a->numBits = numBits;
+    a->numWords = ((uint64_t) numBits + 2 * WORD_BITS - 1) / (2 * WORD_BITS) * 2;
+    a->words = aligned_alloc(16, (a->numWords > 0 ? a->numWords : 2) * sizeof(uint64_t));
+    assert(a->words != NULL);
+    uint32_t i = 0;
+    for (; i < a->numWords; i++)
+        a->words[i] = 0;
+    return a;
+}
+
+/**
+ * Frees the memory allocated to the set.
+ *
+ * @param bp the set to destroy
+ * @timeComplexity O(1)
+ */
+void destroyBitset(BITSET* bp) {
+    assert(bp != NULL);
+    free(bp->words);
+    free(bp);
+}
+
+/**
+ * Adds the integer to the set if it is not a member, or removes it if it is.
+ *
+ * @param bp the set to change
+ * @param bit the integer to toggle
+ * @timeComplexity O(1)
+ */
+void flipBit(BITSET* bp, uint32_t bit) {
+    assert(bp != NULL);
+    assert(bit < bp->numBits);
+    bp->words[bit / WORD_BITS] ^= (uint64_t) 1 << bit % WORD_BITS;
+}
+
+/**
+ * Returns whether the integer is a member of the set.
+ *
+ * @param bp the set to check
+ * @param bit the integer to look for
+ * @return true if the bit is set
+ * @timeComplexity O(1)
+ */
+bool testBit(BITSET* bp, uint32_t bit) {
+    assert(bp != NULL);
+    assert(bit < bp->numBits);
+    return bp->words[bit / WORD_BITS] >> bit % WORD_BITS & 1;
+}
+
+/**
+ * Replaces dst with the symmetric difference of dst and src.
+ * Used to combine bitsets filled by separate threads, since the parity of a word over a whole text is the xor of its parities over the pieces.
+ *
+ * @param dst the set to change
+ * @param src the set to combine into dst, which must have the same number of bits
+ * @timeComplexity O(n) Where n is the number of words
+ */
+void xorBitset(BITSET* dst, BITSET* src) {
+    assert(dst != NULL && src != NULL);
+    assert(dst->numBits == src->numBits);
+    uint32_t i = 0;
+#ifdef __SSE2__
+    for (; i < dst->numWords; i += 2) {
+        __m128i* d = (__m128i*) (dst->words + i);
+        _mm_store_si128(d, _mm_xor_si128(_mm_load_si128(d), _mm_load_si128((const __m128i*) (src->words + i))));
+    }
+#endif
+    for (; i < dst->numWords; i++)
+        dst->words[i] ^= src->words[i];
+}
+
+/**
+ * Returns the number of members of the set.
+ * With SSE2 the bits of two words are counted at once: the usual divide and conquer sums give a count per byte,
+ * and _mm_sad_epu8 adds up the bytes of each half. The per byte counts are at most 8, so the byte sums cannot overflow.
+ *
+ * @param bp the set to count
+ * @return the number of bits set
+ * @timeComplexity O(n) Where n is the number of words
+ */
+uint32_t countBits(BITSET* bp) {
+    assert(bp != NULL);
+    uint64_t count = 0;
+    uint32_t i = 0;
+#ifdef __SSE2__
+    const __m128i m1 = _mm_set1_epi8(0x55);
+    const __m128i m2 = _mm_set1_epi8(0x33);
+    const __m128i m4 = _mm_set1_epi8(0x0f);
+    __m128i total = _mm_setzero_si128();
+    for (; i < bp->numWords; i += 2) {
+        __m128i x = _mm_load_si128((const __m128i*) (bp->words + i));
+        x = _mm_sub_epi8(x, _mm_and_si128(_mm_srli_epi16(x, 1), m1));
+        x = _mm_add_epi8(_mm_and_si128(x, m2), _mm_and_si128(_mm_srli_epi16(x, 2), m2));
+        x = _mm_and_si128(_mm_add_epi8(x, _mm_srli_epi16(x, 4)), m4);
+        total = _mm_add_epi64(total, _mm_sad_epu8(x, _mm_setzero_si128()));
+    }
+    count = (uint64_t) _mm_cvtsi128_si64(total) + (uint64_t) _mm_cvtsi128_si64(_mm_unpackhi_epi64(total, total));
+#endif
+    for (; i < bp->numWords; i++)
+        count += __builtin_popcountll(bp->words[i]);
+    return count;
+}
@@ -0,0 +1,30 @@
+/*
+ * File:        bitset.h
+ *
+ * Description: This file contains the public function and type
+ *              declarations for a fixed-size set of small integers stored
+ *              one bit each.  It is meant for dense IDs such as those
+ *              handed out by the interner or stored in a corpus file.
+ */
+
+# ifndef BITSET_H
+# define BITSET_H
+
+# include <stdint.h>
+# include <stdbool.h>
+
+typedef struct bitset BITSET;
+
+BITSET *createBitset(uint32_t numBits);
+
+void destroyBitset(BITSET *bp);
+
+void flipBit(BITSET *bp, uint32_t bit);
+
+bool testBit(BITSET *bp, uint32_t bit);
+
+void xorBitset(BITSET *dst, BITSET *src);
+
+uint32_t countBits(BITSET *bp);
+
+# endif /* BITSET_H */
@@ -0,0 +1,424 @@
+//corpus.c
+/**
+ * This file (corpus.c) reads and writes dictionary-encoded corpus files.
+ * The layout of a corpus file is:
+ *   bytes 0-7    the magic string "WCORPUS1"
+ *   bytes 8-15   the number of tokens, little endian
+ *   bytes 16-23  the offset of the dictionary, little endian
+ *   bytes 24-27  the number of distinct words, little endian
+ *   bytes 28-31  zero
+ *   then the ID of every token as a varint (7 bits per byte, low bits first)
+ *   then at the dictionary offset, the length of each word as a varint followed by its bytes, in ID order
+ * The dictionary is written last so a text can be encoded in one pass without knowing its vocabulary in advance.
+ *
+ * @author Max Blennemann
+ * @version 10/18/26
+ */
+
+#include "corpus.h"
+#include "pool.h"
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#define MAGIC "WCORPUS1"
+#define HEADER_SIZE 32
+#define BUFFER_SIZE (1 << 16) // Number of bytes of the token stream buffered at a time
+#define MAX_VARINT 5 // Largest number of bytes in the varint of a 32-bit value
+
+typedef struct corpus {
+    FILE* fp; // The corpus file
+    POOL* strings; // Holds the text of every word
+    char** words; // The word of each ID
+    uint32_t numWords; // Number of distinct words
+    long long numTokens; // Number of tokens in the stream
+    long long tokensRead; // Number of tokens returned by nextCorpusToken
+    long long tokenLimit; // Number of tokens nextCorpusToken may return, or -1 if only part of the stream is read
+    long long dictOffset; // Offset of the dictionary, which is also the end of the stream
+    long long streamLeft; // Number of bytes of the stream not yet read into the buffer
+    unsigned char buffer[BUFFER_SIZE];
+    size_t pos; // Index of the next byte of the buffer to decode
+    size_t end; // Number of bytes of the buffer that hold data
+    bool error; // Whether the file was found to be truncated or corrupt
+} corpusReader;
+
+typedef struct corpuswriter {
+    FILE* fp; // The corpus file being written
+    long long numTokens; // Number of tokens written
+    long long streamBytes; // Number of bytes of the stream written
+    unsigned char buffer[BUFFER_SIZE];
+    size_t used; // Number of bytes of the buffer not yet written
+} corpusWriter;
+
+/**
+ * Returns the unsigned integer stored little endian in the given bytes.
+ *
+ * @param p the first byte
+ * @param n the number of bytes
+ * @return the value
+ * @timeComplexity O(n)
+ */
+static uint64_t getLittleEndian(const unsigned char* p, int n) {
+    uint64_t value = 0;
+    while (n-- > 0)
+        value = value << 8 | p[n];
+    return value;
+}
+
+/**
+ * Stores an unsigned integer little endian in the given bytes.
+ *
+ * @param p the first byte
+ * @param value the value to store
+ * @param n the number of bytes
+ * @timeComplexity O(n)
+ */
+static void putLittleEndian(unsigned char* p, uint64_t value, int n) {
+    int i = 0;
+    for (; i < n; i++, value >>= 8)
+        p[i] = value & 0xff;
+}
+
+/**
+ * Reads a varint from a file one byte at a time, for the lengths in the dictionary.
+ *
+ * @param fp the file to read from
+ * @param value set to the value read
+ * @return true if a complete varint was read
+ * @timeComplexity O(1)
+ */
+static bool readVarint(FILE* fp, uint32_t* value) {
+    uint32_t result = 0;
+    int shift = 0;
+    int c;
+    for (; shift < 7 * MAX_VARINT; shift += 7) {
+        if ((c = getc(fp)) == EOF)
+            return false;
+        result |= (uint32_t) (c & 0x7f) << shift;
+        if ((c & 0x80) == 0) {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Stores a value as a varint.
+ *
+ * @param p where to store the varint, with room for MAX_VARINT bytes
+ * @param value the value to store
+ * @return the number of bytes stored
+ * @timeComplexity O(1)
+ */
+static int putVarint(unsigned char* p, uint32_t value) {
+    int n = 0;
+    while (value >= 0x80) {
+        p[n++] = (value & 0x7f) | 0x80;
+        value >>= 7;
+    }
+    p[n++] = value;
+    return n;
+}
+
+/**
+ * Opens a corpus file and reads its dictionary.
+ * If the file is not a corpus file it is rewound and NULL is returned, so the caller can read it as text instead.
+ * If it starts like a corpus file but its header or dictionary is cut short or makes no sense,
+ * a corpus with no words or tokens is returned and corpusError reports it.
+ *
+ * @param fp the file to read, which must be seekable
+ * @return the newly allocated corpus, or NULL if the file is not a corpus file
+ * @timeComplexity O(D) Where D is the size of the dictionary
+ */
+CORPUS* openCorpus(FILE* fp) {
+    assert(fp != NULL);
+    unsigned char header[HEADER_SIZE];
+    if (fread(header, 1, HEADER_SIZE, fp) != HEADER_SIZE || memcmp(header, MAGIC, 8) != 0) {
+        rewind(fp);
+        return NULL;
+    }
+    corpusReader* a = malloc(sizeof(corpusReader));
+    assert(a != NULL);
+    a->fp = fp;
+    a->numTokens = getLittleEndian(header + 8, 8);
+    long long dictOffset = a->dictOffset = getLittleEndian(header + 16, 8);
+    a->numWords = getLittleEndian(header + 24, 4);
+    a->strings = createPool(0);
+    a->tokensRead = 0;
+    a->pos = 0;
+    a->end = 0;
+    a->error = false;
+    long long fileSize = fseeko(fp, 0, SEEK_END) == 0 ? ftello(fp) : -1;
+    if (dictOffset < HEADER_SIZE || dictOffset > fileSize || a->numWords > fileSize - dictOffset
+            || a->numTokens < 0 || a->numTokens > dictOffset - HEADER_SIZE || fseeko(fp, dictOffset, SEEK_SET) != 0) {
+        a->numWords = 0; // Every word takes at least one byte of the dictionary, and every token one of the stream
+        a->error = true;
+    }
+    a->words = malloc((a->numWords + 1) * sizeof(char*));
+    assert(a->words != NULL);
+    size_t length = 256;
+    char* word = malloc(length);
+    assert(word != NULL);
+    uint32_t i = 0;
+    for (; i < a->numWords; i++) {
+        uint32_t n;
+        bool ok = readVarint(fp, &n) && n <= fileSize - dictOffset;
+        if (ok && n > length) {
+            length = n;
+            word = realloc(word, length);
+            assert(word != NULL);
+        }
+        if (!ok || fread(word, 1, n, fp) != n) {
+            a->error = true;
+            break;
+        }
+        a->words[i] = allocString(a->strings, word, n);
+    }
+    free(word);
+    if (!a->error && getc(fp) != EOF)
+        a->error = true; // The dictionary should end the file
+    if (a->error) {
+        a->numWords = 0;
+        a->numTokens = 0;
+        a->tokenLimit = 0;
+        a->streamLeft = 0;
+        return a;
+    }
+    fseeko(fp, HEADER_SIZE, SEEK_SET);
+    a->tokenLimit = a->numTokens;
+    a->streamLeft = dictOffset - HEADER_SIZE;
+    return a;
+}
+
+/**
+ * Frees the memory allocated to the corpus, including its words.
+ * The file is not closed.
+ *
+ * @param cp the corpus to destroy
+ * @timeComplexity O(1)
+ */
+void destroyCorpus(CORPUS* cp) {
+    assert(cp != NULL);
+    destroyPool(cp->strings);
+    free(cp->words);
+    free(cp);
+}
+
+/**
+ * Returns the number of distinct words in the corpus, which is also one more than the largest ID.
+ *
+ * @param cp the corpus to access
+ * @return the number of words
+ * @timeComplexity O(1)
+ */
+int numCorpusWords(CORPUS* cp) {
+    assert(cp != NULL);
+    return cp->numWords;
+}
+
+/**
+ * Returns the word with the given ID.
+ *
+ * @param cp the corpus to access
+ * @param id the ID of the word
+ * @return the word, which stays valid until the corpus is destroyed
+ * @timeComplexity O(1)
+ */
+char* corpusWord(CORPUS* cp, uint32_t id) {
+    assert(cp != NULL);
+    assert(id < cp->numWords);
+    return cp->words[id];
+}
+
+/**
+ * Returns the number of tokens in the corpus, counting every occurrence of every word.
+ *
+ * @param cp the corpus to access
+ * @return the number of tokens
+ * @timeComplexity O(1)
+ */
+long long numCorpusTokens(CORPUS* cp) {
+    assert(cp != NULL);
+    return cp->numTokens;
+}
+
+/**
+ * Returns the ID of the next token in the corpus.
+ * If the stream is cut short, holds a malformed varint or an ID with no word,
+ * or does not hold the number of tokens given in the header, false is returned and corpusError reports it.
+ *
+ * @param cp the corpus to read from
+ * @param id set to the ID of the token
+ * @return true if a token was read, or false at the end of the corpus or if the stream is corrupt
+ * @timeComplexity O(1) amortized
+ */
+bool nextCorpusToken(CORPUS* cp, uint32_t* id) {
+    assert(cp != NULL);
+    if (cp->error)
+        return false;
+    if (cp->tokensRead == cp->tokenLimit) {
+        if (cp->pos < cp->end || cp->streamLeft > 0)
+            cp->error = true; // More tokens than the header says
+        return false;
+    }
+    if (cp->end - cp->pos < MAX_VARINT && cp->streamLeft > 0) {
+        size_t remaining = cp->end - cp->pos;
+        memmove(cp->buffer, cp->buffer + cp->pos, remaining);
+        size_t want = BUFFER_SIZE - remaining;
+        if ((long long) want > cp->streamLeft)
+            want = cp->streamLeft;
+        size_t n = fread(cp->buffer + remaining, 1, want, cp->fp);
+        if (n < want)
+            cp->error = true;
+        cp->streamLeft = n < want ? 0 : cp->streamLeft - n;
+        cp->pos = 0;
+        cp->end = remaining + n;
+    }
+    uint32_t value = 0;
+    int shift = 0;
+    while (cp->pos < cp->end && shift < 7 * MAX_VARINT) {
+        unsigned char c = cp->buffer[cp->pos++];
+        value |= (uint32_t) (c & 0x7f) << shift;
+        if ((c & 0x80) == 0) {
+            if (value >= cp->numWords) {
+                cp->error = true;
+                return false;
+            }
+            *id = value;
+            cp->tokensRead++;
+            return true;
+        }
+        shift += 7;
+    }
+    if (shift > 0 || cp->tokenLimit != -1)
+        cp->error = true; // A varint that never ends, or fewer tokens than the header says
+    return false;
+}
+
+/**
+ * Returns whether the corpus was found to be truncated or corrupt, either when it was opened or while reading its tokens.
+ * Once nextCorpusToken returns false, this tells the end of the corpus from a failure.
+ *
+ * @param cp the corpus to access
+ * @return true if the corpus is truncated or corrupt
+ * @timeComplexity O(1)
+ */
+bool corpusError(CORPUS* cp) {
+    assert(cp != NULL);
+    return cp->error;
+}
+
+/**
+ * Returns the offset of the first varint that starts at or after the given offset of the stream.
+ * A varint ends at the first byte with its high bit clear, so the file only needs to be scanned from the byte before.
+ *
+ * @param cp the corpus to access
+ * @param offset the offset in the file
+ * @return the offset of the next varint, or the dictionary offset if there is none
+ * @timeComplexity O(1)
+ */
+static long long alignToVarint(CORPUS* cp, long long offset) {
+    if (offset <= HEADER_SIZE)
+        return HEADER_SIZE;
+    int c;
+    fseeko(cp->fp, offset - 1, SEEK_SET);
+    for (offset--; offset < cp->dictOffset; offset++)
+        if ((c = getc(cp->fp)) == EOF || (c & 0x80) == 0)
+            return offset + 1;
+    return cp->dictOffset;
+}
+
+/**
+ * Restricts the corpus to one of several equal parts of its token stream, so the parts can be read by separate threads.
+ * Each part is given its own CORPUS opened on its own FILE; together the parts return every token exactly once.
+ * The split is by bytes and moved forward to a varint boundary, so the parts hold about the same number of tokens.
+ * Must be called before the first call to nextCorpusToken.
+ *
+ * @param cp the corpus to restrict
+ * @param part which part to read, from 0 to parts - 1
+ * @param parts the number of parts
+ * @timeComplexity O(1)
+ */
+void seekCorpusPart(CORPUS* cp, int part, int parts) {
+    assert(cp != NULL);
+    assert(parts > 0 && part >= 0 && part < parts);
+    assert(cp->tokensRead == 0 && cp->end == 0);
+    long long length = cp->dictOffset - HEADER_SIZE;
+    long long start = alignToVarint(cp, HEADER_SIZE + length * part / parts);
+    long long end = alignToVarint(cp, HEADER_SIZE + length * (part + 1) / parts);
+    fseeko(cp->fp, start, SEEK_SET);
+    cp->tokenLimit = -1;
+    cp->streamLeft = end - start;
+}
+
+/**
+ * Returns a new writer that encodes a corpus into the given file.
+ * Room for the header is left at the start of the file and filled in by finishCorpus.
+ *
+ * @param fp the file to write, which must be seekable
+ * @return the newly allocated writer
+ * @timeComplexity O(1)
+ */
+CORPUSWRITER* createCorpusWriter(FILE* fp) {
+    assert(fp != NULL);
+    corpusWriter* a = malloc(sizeof(corpusWriter));
+    assert(a != NULL);
+    a->fp = fp;
+    a->numTokens = 0;
+    a->streamBytes = 0;
+    a->used = 0;
+    unsigned char header[HEADER_SIZE] = {0};
+    fwrite(header, 1, HEADER_SIZE, fp);
+    return a;
+}
+
+/**
+ * Appends the ID of the next token to the corpus.
+ *
+ * @param cw the writer to write to
+ * @param id the ID of the token
+ * @timeComplexity O(1) amortized
+ */
+void writeCorpusToken(CORPUSWRITER* cw, uint32_t id) {
+    assert(cw != NULL);
+    if (cw->used + MAX_VARINT > BUFFER_SIZE) {
+        fwrite(cw->buffer, 1, cw->used, cw->fp);
+        cw->used = 0;
+    }
+    int n = putVarint(cw->buffer + cw->used, id);
+    cw->used += n;
+    cw->streamBytes += n;
+    cw->numTokens++;
+}
+
+/**
+ * Writes the dictionary and the header of the corpus and frees the writer.
+ * Every ID written must be less than numWords.
+ *
+ * @param cw the writer to finish
+ * @param words the word of each ID
+ * @param numWords the number of distinct words
+ * @return true if the whole corpus was written successfully
+ * @timeComplexity O(D) Where D is the size of the dictionary
+ */
+bool finishCorpus(CORPUSWRITER* cw, char** words, int numWords) {
+    assert(cw != NULL);
+    assert(numWords >= 0);
+    fwrite(cw->buffer, 1, cw->used, cw->fp);
+    int i = 0;
+    for (; i < numWords; i++) {
+        unsigned char length[MAX_VARINT];
+        size_t n = strlen(words[i]);
+        fwrite(length, 1, putVarint(length, n), cw->fp);
+        fwrite(words[i], 1, n, cw->fp);
+    }
+    unsigned char header[HEADER_SIZE] = {0};
+    memcpy(header, MAGIC, 8);
+    putLittleEndian(header + 8, cw->numTokens, 8);
+    putLittleEndian(header + 16, HEADER_SIZE + cw->streamBytes, 8);
+    putLittleEndian(header + 24, numWords, 4);
+    bool ok = fseeko(cw->fp, 0, SEEK_SET) == 0 && fwrite(header, 1, HEADER_SIZE, cw->fp) == HEADER_SIZE;
+    ok = fflush(cw->fp) == 0 && ok && !ferror(cw->fp);
+    free(cw);
+    return ok;
+}
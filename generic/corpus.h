@@ -0,0 +1,45 @@
+/*
+ * File:        corpus.h
+ *
+ * Description: This file contains the public function and type
+ *              declarations for reading and writing dictionary-encoded
+ *              corpus files.  A corpus file holds a text that has already
+ *              been split into words: a dictionary of the distinct words
+ *              and the sequence of word IDs, each stored as a varint.
+ *              Reading a corpus is an integer scan with no hashing.
+ */
+
+# ifndef CORPUS_H
+# define CORPUS_H
+
+# include <stdio.h>
+# include <stdint.h>
+# include <stdbool.h>
+
+typedef struct corpus CORPUS;
+
+typedef struct corpuswriter CORPUSWRITER;
+
+CORPUS *openCorpus(FILE *fp);
+
+void destroyCorpus(CORPUS *cp);
+
+int numCorpusWords(CORPUS *cp);
+
+char *corpusWord(CORPUS *cp, uint32_t id);
+
+long long numCorpusTokens(CORPUS *cp);
+
+bool nextCorpusToken(CORPUS *cp, uint32_t *id);
+
+bool corpusError(CORPUS *cp);
+
+void seekCorpusPart(CORPUS *cp, int part, int parts);
+
+CORPUSWRITER *createCorpusWriter(FILE *fp);
+
+void writeCorpusToken(CORPUSWRITER *cw, uint32_t id);
+
+bool finishCorpus(CORPUSWRITER *cw, char **words, int numWords);
+
+# endif /* CORPUS_H */
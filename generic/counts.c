@@ -3,23 +3,65 @@
  *
  * Copyright:	2021, Darren C. Atkinson
  *
- * Description: This file contains the main function for testing a set
+ * Description: This file contains the main function for testing a map
  *              abstract data type for strings.
  *
  *              The program takes one file as a command line argument and
  *              counts the number of times each word appears in the file.
+ *              The file may be a corpus file written by encode, in which
+ *              case the counts are kept in an array indexed by word number.
+ *              A text file is split at whitespace, at newlines with the
+ *              --lines option, or at the given characters with --delim,
+ *              and the --normalize option folds case and strips punctuation.
+ *              The --utf8 option treats the text as UTF-8.
+ *
+ *              With the --ngram option, sequences of N consecutive words
+ *              are counted instead.  Each word is interned to an ID, and
+ *              an n-gram is kept in the map as its hash followed by the
+ *              IDs of its words, so no string is built for it.  The hash
+ *              is updated as each word slides into the window using the
+ *              hash the tokenizer already computed for the word.
+ *
+ *              With the -w option only the last N words are counted, and
+ *              with the -t option only the words of the last T seconds, so
+ *              a log can be followed from the standard input.  The window
+ *              is split into buckets (-b), and the K most frequent words
+ *              (-k) of the window are printed each time the oldest bucket
+ *              is dropped from it, and at the end of the input.  Since a
+ *              whole bucket is dropped at once, the window holds between
+ *              B - 1 and B buckets' worth of words.  Time is only checked
+ *              as words arrive.
+ *
+ *              With the -m option the counts are kept in about the given
+ *              number of megabytes.  When they outgrow it they are sorted
+ *              and spilled to a temporary file, and the files are merged
+ *              at the end, adding up the counts, so the words are printed
+ *              in sorted order.
+ *
+ *              With the -p option the counts are made in two passes.  The
+ *              first copies each word, with its hash, into one of 2^P
+ *              partitions by the high bits of the hash, and the second
+ *              counts each partition with its own map, which is small
+ *              enough to stay in the cache and reuses the hash.  The
+ *              partitions are split among the threads given with -j.
  */
 
 # include <stdio.h>
 # include <stdlib.h>
 # include <string.h>
+# include <stdbool.h>
 # include <assert.h>
-# include "set.h"
-
-struct entry {
-    char *word;
-    int count;
-};
+# include <time.h>
+# include "map.h"
+# include "pool.h"
+# include "estimate.h"
+# include "corpus.h"
+# include "tokenizer.h"
+# include "intern.h"
+# include "ring.h"
+# include "spill.h"
+# include "partition.h"
+# include <pthread.h>
 
 
 /* This is sufficient for the test cases in /scratch/coen12. */
@@ -27,6 +69,31 @@ struct entry {
 # define MAX_SIZE 18000
 
 
+/* An n-gram has at most this many words. */
+
+# define MAX_NGRAM 8
+
+
+/* The hash of an n-gram is a polynomial in the hashes of its words. */
+
+# define NGRAM_BASE 0x01000193u
+
+
+/* A window is split into this many buckets unless -b is given. */
+
+# define NUM_BUCKETS 10
+
+
+/* This many words of a window are printed unless -k is given. */
+
+# define NUM_TOP 10
+
+
+/* The most partitions -p may ask for is 2^MAX_BITS. */
+
+# define MAX_BITS 16
+
+
 /*
  * Function:    strhash
  *
@@ -45,27 +112,485 @@ static unsigned strhash(char *s)
 }
 
 
+/* The words in the map are copied into a single string arena. */
+
+static POOL *words;
+
+
+/*
+ * Function:	copyWord
+ *
+ * Description:	Return a copy of a word being added to the map.
+ */
+
+static void *copyWord(char *word)
+{
+    return allocString(words, word, strlen(word));
+}
+
+
+/*
+ * Function:	printCount
+ *
+ * Description:	Print the count of a word.
+ */
+
+static void printCount(char *word, int *count, void *arg)
+{
+    printf("%s: %d\n", word, *count);
+}
+
+
+/* The number of words in an n-gram, or zero to count single words. */
+
+static int ngramSize;
+
+
+/* The n-grams in the map are copied into records of a pool. */
+
+static POOL *ngrams;
+
+
+/* The last few words seen, and the key of the n-gram they form. */
+
+struct window {
+    uint32_t key[MAX_NGRAM + 1];
+    unsigned hashes[MAX_NGRAM];
+    unsigned hash, power;
+    int next, length;
+};
+
+
+/*
+ * Function:	ngramHash
+ *
+ * Description:	Return the hash value of an n-gram KEY, which is stored
+ *		ahead of its IDs.
+ */
+
+static unsigned ngramHash(uint32_t *key)
+{
+    return key[0];
+}
+
+
+/*
+ * Function:	compareNgrams
+ *
+ * Description:	Compare two n-gram keys, which are equal only if their
+ *		hashes and all their IDs are equal.
+ */
+
+static int compareNgrams(uint32_t *key1, uint32_t *key2)
+{
+    return memcmp(key1, key2, (ngramSize + 1) * sizeof(uint32_t));
+}
+
+
 /*
- * Function:	hashEntry
+ * Function:	copyNgram
  *
- * Description:	Return a hash value for an entry based on its word.
+ * Description:	Return a copy of an n-gram key being added to the map.
  */
 
-static unsigned hashEntry(struct entry *ep)
+static void *copyNgram(uint32_t *key)
 {
-    return strhash(ep->word);
+    uint32_t *copy;
+
+
+    copy = allocObject(ngrams);
+    memcpy(copy, key, (ngramSize + 1) * sizeof(uint32_t));
+    return copy;
 }
 
 
 /*
- * Function:	compareEntries
+ * Function:	slideWindow
  *
- * Description:	Compare two entries as in strcmp().
+ * Description:	Slide the window WP along by the word with ID and HASH,
+ *		and count the n-gram it then holds in the map COUNTS.  The
+ *		hash of the oldest word is subtracted out of the n-gram's
+ *		hash rather than hashing every word again.
  */
 
-static int compareEntries(struct entry *ep1, struct entry *ep2)
+static void slideWindow(MAP *counts, struct window *wp, uint32_t id, unsigned hash)
 {
-    return strcmp(ep1->word, ep2->word);
+    unsigned h;
+
+
+    memmove(wp->key + 1, wp->key + 2, (ngramSize - 1) * sizeof(uint32_t));
+    wp->key[ngramSize] = id;
+
+    wp->hash = (wp->hash - wp->hashes[wp->next] * wp->power) * NGRAM_BASE + hash;
+    wp->hashes[wp->next] = hash;
+    wp->next = (wp->next + 1) % ngramSize;
+
+    if (++ wp->length >= ngramSize) {
+	h = wp->hash;
+	h ^= h >> 16;
+	h *= 0x45d9f3b;
+	wp->key[0] = h ^ h >> 16;
+	incrementValue(counts, wp->key, 1);
+    }
+}
+
+
+/*
+ * Function:	printNgram
+ *
+ * Description:	Print the count of an n-gram, looking up its words in the
+ *		array NAMES indexed by ID.
+ */
+
+static void printNgram(uint32_t *key, int *count, char **names)
+{
+    int i;
+
+
+    for (i = 1; i <= ngramSize; i ++)
+	printf(i > 1 ? " %s" : "%s", names[key[i]]);
+
+    printf(": %d\n", *count);
+}
+
+
+/*
+ * Function:	printNgramCounts
+ *
+ * Description:	Print the number of times each n-gram appears in the
+ *		corpus CP, or if it is NULL, in the words of the tokenizer
+ *		TP.  The words of a corpus are already numbered, and the
+ *		ID of each word is used as its hash.  Return false without
+ *		printing anything if the corpus is truncated or corrupt.
+ */
+
+static bool printNgramCounts(CORPUS *cp, TOKENIZER *tp, int size)
+{
+    struct window w;
+    struct token tok;
+    INTERNER *ip = NULL;
+    MAP *counts;
+    char **names;
+    uint32_t id;
+    int i;
+
+
+    ngrams = createPool((ngramSize + 1) * sizeof(uint32_t));
+    counts = createMap(size, sizeof(int), compareNgrams, ngramHash, copyNgram);
+
+    memset(&w, 0, sizeof(w));
+    w.power = 1;
+
+    for (i = 1; i < ngramSize; i ++)
+	w.power *= NGRAM_BASE;
+
+    if (cp != NULL) {
+	while (nextCorpusToken(cp, &id))
+	    slideWindow(counts, &w, id, id * 0x9e3779b1u);
+
+	if (corpusError(cp)) {
+	    destroyMap(counts);
+	    destroyPool(ngrams);
+	    return false;
+	}
+
+	names = malloc((numCorpusWords(cp) + 1) * sizeof(char *));
+	assert(names != NULL);
+
+	for (id = 0; id < numCorpusWords(cp); id ++)
+	    names[id] = corpusWord(cp, id);
+
+    } else {
+	ip = createInterner(size);
+
+	while (nextToken(tp, &tok))
+	    slideWindow(counts, &w, internWord(ip, tok.text), tok.hash);
+
+	names = getWords(ip);
+    }
+
+    forEachEntry(counts, printNgram, names);
+
+    if (ip != NULL)
+	destroyInterner(ip);
+    else
+	free(names);
+
+    destroyMap(counts);
+    destroyPool(ngrams);
+    return true;
+}
+
+
+/*
+ * Function:	milliseconds
+ *
+ * Description:	Return the time in milliseconds since some fixed point.
+ *		A coarse clock is used if there is one, since it is read
+ *		for every word.
+ */
+
+static long long milliseconds(void)
+{
+    struct timespec ts;
+
+
+# ifdef CLOCK_MONOTONIC_COARSE
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+# else
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+# endif
+    return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+}
+
+
+/*
+ * Function:	printTop
+ *
+ * Description:	Print the K most frequent words of the ring RP using the
+ *		arrays WORDS and COUNTS, followed by a blank line.
+ */
+
+static void printTop(RING *rp, int k, char **words, int *counts)
+{
+    int i, n;
+
+
+    n = topRingWords(rp, k, words, counts);
+
+    for (i = 0; i < n; i ++)
+	printf("%s: %d\n", words[i], counts[i]);
+
+    putchar('\n');
+}
+
+
+/*
+ * Function:	printWindowCounts
+ *
+ * Description:	Count the words of the tokenizer TP over a window of the
+ *		last WIDTH words, or if SECONDS is true, of the last WIDTH
+ *		seconds, split into BUCKETS buckets.  The K most frequent
+ *		words are printed as each bucket is dropped and at the end.
+ */
+
+static void printWindowCounts(TOKENIZER *tp, long width, bool seconds, int buckets, int k, int size)
+{
+    RING *rp;
+    struct token tok;
+    char **words;
+    int *counts;
+    long long step, start, bucket, next, count;
+
+
+    if (!seconds && buckets > width)
+	buckets = width;
+
+    rp = createRing(buckets, size);
+    words = malloc(k * sizeof(char *));
+    counts = malloc(k * sizeof(int));
+    assert(words != NULL && counts != NULL);
+
+    step = seconds ? width * 1000 / buckets : width / buckets;
+    step = step > 0 ? step : 1;
+    start = seconds ? milliseconds() : 0;
+    bucket = count = 0;
+
+    while (nextToken(tp, &tok)) {
+	next = ((seconds ? milliseconds() : count ++) - start) / step;
+
+	if (next > bucket) {
+	    printTop(rp, k, words, counts);
+	    advanceRing(rp, next - bucket < buckets ? next - bucket : buckets);
+	    bucket = next;
+	}
+
+	addToRing(rp, tok.text);
+    }
+
+    printTop(rp, k, words, counts);
+
+    free(words);
+    free(counts);
+    destroyRing(rp);
+}
+
+
+/*
+ * Function:	printSpilledCounts
+ *
+ * Description:	Print the number of times each word of the tokenizer TP
+ *		appears, in sorted order, keeping about BUDGET bytes of
+ *		counts in memory.  Return false if the counts that were
+ *		spilled could not be written.
+ */
+
+static bool printSpilledCounts(TOKENIZER *tp, size_t budget)
+{
+    SPILL *sp;
+    struct token tok;
+    char *word;
+    long count;
+
+
+    sp = createSpill(budget);
+
+    while (nextToken(tp, &tok))
+	addToSpill(sp, tok.text, 1);
+
+    if (!finishSpill(sp)) {
+	destroySpill(sp);
+	return false;
+    }
+
+    while (nextSpilled(sp, &word, &count))
+	printf("%s: %ld\n", word, count);
+
+    destroySpill(sp);
+    return true;
+}
+
+
+/* The partitions counted by a thread: every Nth one from the first. */
+
+struct job {
+    PARTITIONS *pp;
+    MAP **maps;
+    int first, step, size;
+    bool threaded;
+};
+
+
+/*
+ * Function:	countWord
+ *
+ * Description:	Increment the count of a word copied into a partition.
+ */
+
+static void countWord(char *word, MAP *counts)
+{
+    incrementValue(counts, word, 1);
+}
+
+
+/*
+ * Function:	countPartitions
+ *
+ * Description:	Count the words of each partition of the job JP in a new
+ *		map of its own.
+ */
+
+static void *countPartitions(void *jp)
+{
+    struct job *job = jp;
+    int i;
+
+
+    for (i = job->first; i < numPartitions(job->pp); i += job->step) {
+	job->maps[i] = createMap(job->size, sizeof(int), strcmp, partitionedHash, NULL);
+	forEachWord(job->pp, i, countWord, job->maps[i]);
+    }
+
+    return NULL;
+}
+
+
+/*
+ * Function:	printPartitionedCounts
+ *
+ * Description:	Print the number of times each word of the tokenizer TP
+ *		appears, first scattering the words into 2^BITS partitions
+ *		and then counting the partitions with THREADS threads.
+ */
+
+static void printPartitionedCounts(TOKENIZER *tp, int bits, int threads, int size)
+{
+    PARTITIONS *pp;
+    struct token tok;
+    struct job *jobs;
+    pthread_t *tids;
+    MAP **maps;
+    int i;
+
+
+    pp = createPartitions(bits);
+
+    while (nextToken(tp, &tok))
+	scatterWord(pp, tok.text, tok.length, tok.hash);
+
+    flushPartitions(pp);
+
+    if (threads > numPartitions(pp))
+	threads = numPartitions(pp);
+
+    maps = malloc(numPartitions(pp) * sizeof(MAP *));
+    jobs = malloc(threads * sizeof(struct job));
+    tids = malloc(threads * sizeof(pthread_t));
+    assert(maps != NULL && jobs != NULL && tids != NULL);
+
+    for (i = 0; i < threads; i ++) {
+	jobs[i].pp = pp;
+	jobs[i].maps = maps;
+	jobs[i].first = i;
+	jobs[i].step = threads;
+	jobs[i].size = size / numPartitions(pp) + 1;
+	jobs[i].threaded = i > 0 && pthread_create(&tids[i], NULL, countPartitions, &jobs[i]) == 0;
+    }
+
+
+    /* The first job, and any whose thread could not be created, run on
+       this thread. */
+
+    for (i = 0; i < threads; i ++)
+	if (!jobs[i].threaded)
+	    countPartitions(&jobs[i]);
+
+    for (i = 1; i < threads; i ++)
+	if (jobs[i].threaded)
+	    pthread_join(tids[i], NULL);
+
+    for (i = 0; i < numPartitions(pp); i ++) {
+	forEachEntry(maps[i], printCount, NULL);
+	destroyMap(maps[i]);
+    }
+
+    free(tids);
+    free(jobs);
+    free(maps);
+    destroyPartitions(pp);
+}
+
+
+/*
+ * Function:	printCorpusCounts
+ *
+ * Description:	Print the number of times each word of the corpus CP
+ *		appears in it.  Return false without printing anything if
+ *		the corpus is truncated or corrupt.
+ */
+
+static bool printCorpusCounts(CORPUS *cp)
+{
+    int *tally;
+    uint32_t id;
+
+
+    tally = calloc(numCorpusWords(cp) + 1, sizeof(int));
+    assert(tally != NULL);
+
+    while (nextCorpusToken(cp, &id))
+	tally[id] ++;
+
+    if (corpusError(cp)) {
+	free(tally);
+	return false;
+    }
+
+    for (id = 0; id < numCorpusWords(cp); id ++)
+	printf("%s: %d\n", corpusWord(cp, id), tally[id]);
+
+    free(tally);
+    return true;
 }
 
 
@@ -78,16 +603,100 @@ static int compareEntries(struct entry *ep1, struct entry *ep2)
 int main(int argc, char *argv[])
 {
     FILE *fp;
-    char buffer[BUFSIZ];
-    struct entry e, *ep, **entries;
-    SET *counts;
-    int i;
+    char *delimiters = NULL;
+    TOKENIZER *tp;
+    struct token tok;
+    MAP *counts;
+    CORPUS *corpus;
+    int i, size, buckets = NUM_BUCKETS, k = NUM_TOP, bits = 0, threads = 1;
+    long width = 0, megabytes = 0;
+    bool sflag = false, tflag = false, lines = false, normalize = false, utf8 = false, ok;
 
 
     /* Check usage and open the file. */
 
-    if (argc != 2) {
-        fprintf(stderr, "usage: %s file\n", argv[0]);
+    while (argc > 1 && argv[1][0] == '-') {
+	if (strcmp(argv[1], "--lines") == 0)
+	    lines = true;
+	else if (strcmp(argv[1], "--normalize") == 0)
+	    normalize = true;
+	else if (strcmp(argv[1], "--utf8") == 0)
+	    utf8 = true;
+	else if (strncmp(argv[1], "--delim=", 8) == 0 && argv[1][8] != '\0')
+	    delimiters = argv[1] + 8;
+	else if (strcmp(argv[1], "-s") == 0)
+	    sflag = true;
+	else if (strcmp(argv[1], "--ngram") == 0) {
+	    if (argc < 3 || (ngramSize = atoi(argv[2])) < 1 || ngramSize > MAX_NGRAM) {
+		ngramSize = -1;
+		break;
+	    }
+
+	    argc --;
+
+	    for (i = 1; i < argc; i ++)
+		argv[i] = argv[i + 1];
+	} else if (argv[1][1] != '\0' && argv[1][2] == '\0' && strchr("wtbkmpj", argv[1][1]) != NULL) {
+	    if (argc < 3 || atol(argv[2]) < 1) {
+		width = -1;
+		break;
+	    }
+
+	    if (argv[1][1] == 'b')
+		buckets = atoi(argv[2]);
+	    else if (argv[1][1] == 'k')
+		k = atoi(argv[2]);
+	    else if (argv[1][1] == 'm')
+		megabytes = atol(argv[2]);
+	    else if (argv[1][1] == 'p')
+		bits = atoi(argv[2]);
+	    else if (argv[1][1] == 'j')
+		threads = atoi(argv[2]);
+	    else {
+		width = atol(argv[2]);
+		tflag = argv[1][1] == 't';
+	    }
+
+	    argc --;
+
+	    for (i = 1; i < argc; i ++)
+		argv[i] = argv[i + 1];
+	} else
+	    break;
+
+	argc --;
+
+	for (i = 1; i < argc; i ++)
+	    argv[i] = argv[i + 1];
+    }
+
+    if (width > 0 && ngramSize == 0 && bits == 0 && argc <= 2) {
+	fp = argc == 1 || strcmp(argv[1], "-") == 0 ? stdin : fopen(argv[1], "r");
+
+	if (fp == NULL) {
+	    fprintf(stderr, "%s: cannot open %s\n", argv[0], argv[1]);
+	    exit(EXIT_FAILURE);
+	}
+
+	tp = createTokenizer(fp);
+	setTokenizerLines(tp, lines);
+	setTokenizerNormalize(tp, normalize);
+	setTokenizerUtf8(tp, utf8);
+	setTokenizerStreaming(tp, stdout);
+
+	if (delimiters != NULL)
+	    setTokenizerDelimiters(tp, delimiters);
+
+	printWindowCounts(tp, width, tflag, buckets, k, MAX_SIZE);
+	destroyTokenizer(tp);
+	fclose(fp);
+	exit(EXIT_SUCCESS);
+    }
+
+    if (argc != 2 || ngramSize < 0 || width != 0 || (megabytes > 0 && ngramSize > 0) || bits > MAX_BITS || (bits > 0 && (ngramSize > 0 || megabytes > 0))) {
+        fprintf(stderr, "usage: %s [-s | -m megabytes] [--lines | --delim=chars] [--normalize] [--utf8] [--ngram n] file\n", argv[0]);
+        fprintf(stderr, "       %s -p bits [-j threads] [-s] [--lines | --delim=chars] [--normalize] [--utf8] file\n", argv[0]);
+        fprintf(stderr, "       %s -w words | -t seconds [-b buckets] [-k top] [--lines | --delim=chars] [--normalize] [--utf8] [file]\n", argv[0]);
         exit(EXIT_FAILURE);
     }
 
@@ -97,41 +706,78 @@ int main(int argc, char *argv[])
     }
 
 
-    /* Increment the count on each word read. */
+    /* A corpus file is counted by word number without a map. */
+
+    if ((corpus = openCorpus(fp)) != NULL) {
+	ok = ngramSize > 0 ? printNgramCounts(corpus, NULL, MAX_SIZE) : printCorpusCounts(corpus);
+	destroyCorpus(corpus);
+	fclose(fp);
+
+	if (!ok) {
+	    fprintf(stderr, "%s: corrupt corpus %s\n", argv[0], argv[1]);
+	    exit(EXIT_FAILURE);
+	}
+
+	exit(EXIT_SUCCESS);
+    }
+
+
+    /* Size the map from a sample of the file if desired. */
 
-    counts = createSet(MAX_SIZE, compareEntries, hashEntry);
+    size = sflag ? estimateWords(fp, MAX_SIZE) * 4 / 3 + 1 : MAX_SIZE;
 
-    while (fscanf(fp, "%s", buffer) == 1) {
-	e.word = buffer;
-	ep = findElement(counts, &e);
 
-	if (ep == NULL) {
-	    ep = malloc(sizeof(struct entry));
-	    assert(ep != NULL);
+    /* Increment the count on each word, or n-gram, read. */
 
-	    ep->word = strdup(buffer);
-	    assert(ep->word != NULL);
+    tp = createTokenizer(fp);
+    setTokenizerLines(tp, lines);
+    setTokenizerNormalize(tp, normalize);
+    setTokenizerUtf8(tp, utf8);
 
-	    ep->count = 1;
-	    addElement(counts, ep);
+    if (delimiters != NULL)
+	setTokenizerDelimiters(tp, delimiters);
 
-	} else
-	    ep->count ++;
+    if (ngramSize > 0) {
+	printNgramCounts(NULL, tp, size);
+	destroyTokenizer(tp);
+	fclose(fp);
+	exit(EXIT_SUCCESS);
     }
 
+    if (megabytes > 0) {
+	if (!printSpilledCounts(tp, megabytes << 20)) {
+	    fprintf(stderr, "%s: cannot write temporary file\n", argv[0]);
+	    exit(EXIT_FAILURE);
+	}
 
-    /* Print out the counts for each word. */
-
-    entries = getElements(counts);
+	destroyTokenizer(tp);
+	fclose(fp);
+	exit(EXIT_SUCCESS);
+    }
 
-    for (i = 0; i < numElements(counts); i ++) {
-	printf("%s: %d\n", entries[i]->word, entries[i]->count);
-	free(entries[i]->word);
-	free(entries[i]);
+    if (bits > 0) {
+	printPartitionedCounts(tp, bits, threads, size);
+	destroyTokenizer(tp);
+	fclose(fp);
+	exit(EXIT_SUCCESS);
     }
 
-    free(entries);
+    words = createPool(0);
+    counts = createMap(size, sizeof(int), strcmp, strhash, copyWord);
+
+    while (nextToken(tp, &tok))
+	incrementValue(counts, tok.text, 1);
+
+    destroyTokenizer(tp);
+
+    fclose(fp);
+
+
+    /* Print out the counts for each word. */
+
+    forEachEntry(counts, printCount, NULL);
 
-    destroySet(counts);
+    destroyMap(counts);
+    destroyPool(words);
     exit(EXIT_SUCCESS);
 }
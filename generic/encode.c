@@ -0,0 +1,94 @@
+/*
+ * File:        encode.c
+ *
+ * Description: This file contains the main function for converting a text
+ *              file into a dictionary-encoded corpus file.
+ *
+ *              The program takes two files as command line arguments.  The
+ *              words of the first file are numbered in the order they first
+ *              appear and the second file is written with the dictionary
+ *              and the sequence of word numbers.  The unique, parity and
+ *              counts programs accept the corpus file in place of the text,
+ *              without tokenizing or hashing it again.  With the
+ *              --normalize option, words are lowercased and stripped of
+ *              punctuation before they are numbered, and with --utf8 the
+ *              text is treated as UTF-8.
+ */
+
+# include <stdio.h>
+# include <stdlib.h>
+# include <string.h>
+# include <stdbool.h>
+# include "tokenizer.h"
+# include "intern.h"
+# include "corpus.h"
+
+
+/*
+ * Function:    main
+ *
+ * Description: Driver function for the converter.
+ */
+
+int main(int argc, char *argv[])
+{
+    FILE *in, *out;
+    TOKENIZER *tp;
+    INTERNER *ip;
+    CORPUSWRITER *cw;
+    struct token tok;
+    bool normalize = false, utf8 = false;
+    int i;
+
+
+    /* Check usage and open the files. */
+
+    while (argc > 1 && (strcmp(argv[1], "--normalize") == 0 || strcmp(argv[1], "--utf8") == 0)) {
+	if (argv[1][2] == 'n')
+	    normalize = true;
+	else
+	    utf8 = true;
+
+	argc --;
+
+	for (i = 1; i < argc; i ++)
+	    argv[i] = argv[i + 1];
+    }
+
+    if (argc != 3) {
+        fprintf(stderr, "usage: %s [--normalize] [--utf8] textfile corpusfile\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    if ((in = fopen(argv[1], "r")) == NULL) {
+        fprintf(stderr, "%s: cannot open %s\n", argv[0], argv[1]);
+        exit(EXIT_FAILURE);
+    }
+
+    if ((out = fopen(argv[2], "wb")) == NULL) {
+        fprintf(stderr, "%s: cannot create %s\n", argv[0], argv[2]);
+        exit(EXIT_FAILURE);
+    }
+
+
+    /* Number every word and write the sequence of numbers. */
+
+    tp = createTokenizer(in);
+    setTokenizerNormalize(tp, normalize);
+    setTokenizerUtf8(tp, utf8);
+    ip = createInterner(1024);
+    cw = createCorpusWriter(out);
+
+    while (nextToken(tp, &tok))
+	writeCorpusToken(cw, internWord(ip, tok.text));
+
+    if (!finishCorpus(cw, getWords(ip), numWords(ip)) || fclose(out) != 0) {
+        fprintf(stderr, "%s: cannot write %s\n", argv[0], argv[2]);
+        exit(EXIT_FAILURE);
+    }
+
+    fclose(in);
+    destroyTokenizer(tp);
+    destroyInterner(ip);
+    exit(EXIT_SUCCESS);
+}
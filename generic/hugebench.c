@@ -0,0 +1,193 @@
+/*
+ * File:        hugebench.c
+ *
+ * Description: This file contains the main function for measuring the
+ *              effect of backing large set tables with transparent huge
+ *              pages.
+ *
+ *              The program takes an optional number of keys as a command
+ *              line argument.  A set of that many integer keys is built
+ *              with huge pages turned off and then on, and for each the
+ *              time per random lookup and the number of data TLB misses
+ *              are printed.  TLB misses are reported only if the kernel
+ *              allows this process to count them.
+ */
+
+# include <stdio.h>
+# include <stdlib.h>
+# include <stdint.h>
+# include <string.h>
+# include <time.h>
+# include <unistd.h>
+# include <sys/ioctl.h>
+# include <sys/syscall.h>
+# include <linux/perf_event.h>
+# include "set.h"
+
+
+# define DEFAULT_KEYS 100000000
+# define LOOKUPS 20000000
+
+
+/*
+ * Function:    seconds
+ *
+ * Description: Return the current time in seconds.
+ */
+
+static double seconds(void)
+{
+    struct timespec ts;
+
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+/*
+ * Function:    openTlbCounter
+ *
+ * Description: Return a file descriptor counting data TLB read misses of
+ *              this process, or -1 if they can not be counted.
+ */
+
+static int openTlbCounter(void)
+{
+    struct perf_event_attr attr;
+
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_DTLB |
+	PERF_COUNT_HW_CACHE_OP_READ << 8 |
+	PERF_COUNT_HW_CACHE_RESULT_MISS << 16;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    return syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+
+/*
+ * Function:    hashKey
+ *
+ * Description: Return a hash value for a boxed integer key.
+ */
+
+static unsigned hashKey(uint64_t *kp)
+{
+    uint64_t k = *kp;
+
+
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    return (unsigned) k;
+}
+
+
+/*
+ * Function:    compareKeys
+ *
+ * Description: Compare two boxed integer keys.
+ */
+
+static int compareKeys(uint64_t *kp1, uint64_t *kp2)
+{
+    return *kp1 < *kp2 ? -1 : *kp1 > *kp2;
+}
+
+
+/*
+ * Function:    run
+ *
+ * Description: Build a set of the first N keys with the given huge page
+ *              threshold, then time LOOKUPS random lookups.
+ */
+
+static void run(char *name, uint64_t *keys, int n, size_t threshold)
+{
+    SET *sp;
+    double start, elapsed;
+    long long misses;
+    int i, fd, hits;
+    uint64_t state = 7;
+
+
+    sp = createSet(16, compareKeys, hashKey);
+    setHugePageThreshold(sp, threshold);
+    reserveSet(sp, n);
+
+    for (i = 0; i < n; i ++)
+	addElement(sp, &keys[i]);
+
+    fd = openTlbCounter();
+
+    if (fd >= 0) {
+	ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+	ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+
+    start = seconds();
+    hits = 0;
+
+    for (i = 0; i < LOOKUPS; i ++) {
+	state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+	hits += findElement(sp, &keys[(state >> 33) % n]) != NULL;
+    }
+
+    elapsed = seconds() - start;
+    printf("%-10s %.1f ns/lookup (%d hits)", name, elapsed / LOOKUPS * 1e9, hits);
+
+    if (fd >= 0) {
+	ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+
+	if (read(fd, &misses, sizeof(misses)) == sizeof(misses))
+	    printf(", %.3f dTLB misses/lookup", (double) misses / LOOKUPS);
+
+	close(fd);
+    } else
+	printf(", dTLB misses not available");
+
+    printf("\n");
+    destroySet(sp);
+}
+
+
+/*
+ * Function:    main
+ *
+ * Description: Driver function for the benchmark.
+ */
+
+int main(int argc, char *argv[])
+{
+    uint64_t *keys;
+    int i, n;
+
+
+    n = argc > 1 ? atoi(argv[1]) : DEFAULT_KEYS;
+
+    if (argc > 2 || n <= 0) {
+        fprintf(stderr, "usage: %s [keys]\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    if ((keys = malloc(n * sizeof(uint64_t))) == NULL) {
+        fprintf(stderr, "%s: out of memory\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    for (i = 0; i < n; i ++)
+	keys[i] = (uint64_t) i * 0x9e3779b97f4a7c15ULL;
+
+    printf("%d keys, %.0f MB of slots\n", n, n * 4.0 / 3 * (sizeof(void *) + 1) / (1 << 20));
+    run("4 KB pages", keys, n, 0);
+    run("huge pages", keys, n, 1);
+
+    free(keys);
+    exit(EXIT_SUCCESS);
+}
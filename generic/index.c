@@ -0,0 +1,554 @@
+/*
+ * File:        index.c
+ *
+ * Description: This file contains the main function for building an
+ *              inverted index of text files and answering queries from
+ *              the saved index.
+ *
+ *              To build an index, the program takes the name of the index
+ *              file followed by one or more text files.  A set holds an
+ *              entry for each distinct word, found with the hash the
+ *              tokenizer already computed, and each entry has a compressed
+ *              posting list of the lines the word appears on, or with the
+ *              -w option, of its word offsets.  Positions are numbered
+ *              across all the files, so each list is increasing.
+ *
+ *              With the -q option, the program takes the name of an index
+ *              file and one or more words, and prints the file and line of
+ *              each line containing all the words, or for a word index, the
+ *              file and word offset of each place the words appear as a
+ *              phrase.  Only the dictionary and the posting lists of the
+ *              words asked for are read.
+ *
+ *              All numbers in an index file are four bytes, little endian.
+ *              The file holds the magic string "WINDEX1" and a null, then
+ *              whether positions are word offsets, the number of files,
+ *              and the length, name and first position of each file.  Then
+ *              come the number of words, and the length and text of each
+ *              word with the number of its positions and the length of its
+ *              encoded posting list.  The posting lists follow, in the same
+ *              order as the words.
+ */
+
+# include <stdio.h>
+# include <stdlib.h>
+# include <string.h>
+# include <stdbool.h>
+# include <stdint.h>
+# include <assert.h>
+# include "set.h"
+# include "pool.h"
+# include "tokenizer.h"
+# include "postings.h"
+
+
+/* The initial size of the set of words; it grows as needed. */
+
+# define MAX_SIZE 18000
+
+
+# define MAGIC "WINDEX1"
+# define MAGIC_SIZE 8
+
+
+/* A distinct word and the positions at which it appears. */
+
+struct entry {
+    char *word;
+    POSTINGS *list;
+};
+
+
+/* A word being queried and where its posting list is in the index. */
+
+struct query {
+    char *word;
+    bool found;
+    uint32_t count, length;
+    long long offset;
+    uint32_t *positions;
+};
+
+
+/*
+ * Function:    strhash
+ *
+ * Description: Return a hash value for a string S.
+ */
+
+static unsigned strhash(char *s)
+{
+    unsigned hash = 0;
+
+
+    while (*s != '\0')
+        hash = 31 * hash + *s ++;
+
+    return hash;
+}
+
+
+/*
+ * Function:	entryHash
+ *
+ * Description:	Return a hash value for an entry EP, which is the hash
+ *		value of its word.
+ */
+
+static unsigned entryHash(struct entry *ep)
+{
+    return strhash(ep->word);
+}
+
+
+/*
+ * Function:	compareEntries
+ *
+ * Description:	Compare the words of two entries EP1 and EP2.
+ */
+
+static int compareEntries(struct entry *ep1, struct entry *ep2)
+{
+    return strcmp(ep1->word, ep2->word);
+}
+
+
+/*
+ * Function:	compareWord
+ *
+ * Description:	Compare the word of an entry EP with a WORD.
+ */
+
+static int compareWord(struct entry *ep, char *word)
+{
+    return strcmp(ep->word, word);
+}
+
+
+/*
+ * Function:	putNumber
+ *
+ * Description:	Write the number N to the file FP as four bytes, little
+ *		endian.
+ */
+
+static void putNumber(FILE *fp, uint32_t n)
+{
+    unsigned char bytes[4];
+
+
+    bytes[0] = n;
+    bytes[1] = n >> 8;
+    bytes[2] = n >> 16;
+    bytes[3] = n >> 24;
+    fwrite(bytes, 1, 4, fp);
+}
+
+
+/*
+ * Function:	getNumber
+ *
+ * Description:	Read a number written by putNumber from the file FP into
+ *		N, returning false at the end of the file.
+ */
+
+static bool getNumber(FILE *fp, uint32_t *n)
+{
+    unsigned char bytes[4];
+
+
+    if (fread(bytes, 1, 4, fp) != 4)
+	return false;
+
+    *n = bytes[0] | bytes[1] << 8 | bytes[2] << 16 | (uint32_t) bytes[3] << 24;
+    return true;
+}
+
+
+/*
+ * Function:	bytesLeft
+ *
+ * Description:	Return the number of bytes of the file FP of SIZE bytes
+ *		after the current position.
+ */
+
+static long long bytesLeft(FILE *fp, long long size)
+{
+    return size - ftell(fp);
+}
+
+
+/*
+ * Function:	buildIndex
+ *
+ * Description:	Write an index of the NUMFILES text FILES to the file
+ *		named NAME, of word offsets if WFLAG is true or else of
+ *		lines.  Return false if the index cannot be written.
+ */
+
+static bool buildIndex(char *name, char **files, int numFiles, bool wflag)
+{
+    FILE *fp, *out;
+    TOKENIZER *tp;
+    struct token tok;
+    struct entry *ep, **entries;
+    uint32_t *bases;
+    unsigned long long base, position, offset, postings, bytes;
+    const unsigned char *data;
+    size_t length;
+    POOL *records, *strings;
+    SET *sp;
+    bool ok;
+    int i, n;
+
+
+    sp = createSet(MAX_SIZE, compareEntries, entryHash);
+    setLookupFunctions(sp, compareWord, NULL);
+    records = createPool(sizeof(struct entry));
+    strings = createPool(0);
+    bases = malloc(numFiles * sizeof(uint32_t));
+    assert(bases != NULL);
+    base = 0;
+
+
+    /* Add the position of every word of every file to its list.  The
+       positions must fit in 32 bits. */
+
+    for (i = 0; i < numFiles; i ++) {
+	if ((fp = fopen(files[i], "r")) == NULL) {
+	    fprintf(stderr, "index: cannot open %s\n", files[i]);
+	    exit(EXIT_FAILURE);
+	}
+
+	if (base > UINT32_MAX) {
+	    fprintf(stderr, "index: too many positions at %s\n", files[i]);
+	    exit(EXIT_FAILURE);
+	}
+
+	bases[i] = base;
+	tp = createTokenizer(fp);
+	offset = 0;
+	tok.line = 0;
+
+	while (nextToken(tp, &tok)) {
+	    position = base + (wflag ? offset ++ : tok.line - 1);
+
+	    if (position > UINT32_MAX) {
+		fprintf(stderr, "index: too many positions in %s\n", files[i]);
+		exit(EXIT_FAILURE);
+	    }
+
+	    if ((ep = findElementByHash(sp, tok.text, tok.hash)) == NULL) {
+		ep = allocObject(records);
+		ep->word = allocString(strings, tok.text, tok.length);
+		ep->list = createPostings();
+		addElement(sp, ep);
+	    }
+
+	    if (numPostings(ep->list) == 0 || lastPosting(ep->list) != position)
+		addPosting(ep->list, position);
+	}
+
+	base += wflag ? offset + 1 : tok.line; /* no phrase spans two files */
+	destroyTokenizer(tp);
+	fclose(fp);
+    }
+
+
+    /* Write the files, then the dictionary, then the posting lists. */
+
+    if ((out = fopen(name, "wb")) == NULL)
+	return false;
+
+    fwrite(MAGIC, 1, MAGIC_SIZE, out);
+    putNumber(out, wflag);
+    putNumber(out, numFiles);
+
+    for (i = 0; i < numFiles; i ++) {
+	putNumber(out, strlen(files[i]));
+	fputs(files[i], out);
+	putNumber(out, bases[i]);
+    }
+
+    n = numElements(sp);
+    entries = getElements(sp);
+    putNumber(out, n);
+    postings = bytes = 0;
+
+    for (i = 0; i < n; i ++) {
+	finishPostings(entries[i]->list, &length);
+	putNumber(out, strlen(entries[i]->word));
+	fputs(entries[i]->word, out);
+	putNumber(out, numPostings(entries[i]->list));
+	putNumber(out, length);
+	postings += numPostings(entries[i]->list);
+	bytes += length;
+    }
+
+    for (i = 0; i < n; i ++) {
+	data = finishPostings(entries[i]->list, &length);
+	fwrite(data, 1, length, out);
+	destroyPostings(entries[i]->list);
+    }
+
+    ok = !ferror(out);
+    ok = fclose(out) == 0 && ok;
+
+    if (ok) {
+	printf("%d files\n", numFiles);
+	printf("%d distinct words\n", n);
+	printf("%llu %s\n", postings, wflag ? "word positions" : "line positions");
+	printf("%llu bytes of posting lists\n", bytes);
+    }
+
+    free(entries);
+    free(bases);
+    destroySet(sp);
+    destroyPool(records);
+    destroyPool(strings);
+    return ok;
+}
+
+
+/*
+ * Function:	matchPositions
+ *
+ * Description:	Keep only the positions P of the NUM positions in LIST
+ *		for which P + SHIFT is one of the COUNT positions in OTHER,
+ *		and return how many are left.  Both arrays are increasing,
+ *		so one merge finds them.
+ */
+
+static uint32_t matchPositions(uint32_t *list, uint32_t num, uint32_t *other, uint32_t count, uint32_t shift)
+{
+    uint32_t i, j, kept;
+
+
+    for (i = j = kept = 0; i < num; i ++) {
+	while (j < count && other[j] < list[i] + shift)
+	    j ++;
+
+	if (j < count && other[j] == list[i] + shift)
+	    list[kept ++] = list[i];
+    }
+
+    return kept;
+}
+
+
+/*
+ * Function:	queryIndex
+ *
+ * Description:	Print where the NUMWORDS WORDS appear together in the
+ *		index file FP: on the same line for a line index, or as a
+ *		phrase for a word index.  Return false if the file is not
+ *		an index, which includes any count or length that does not
+ *		fit in what is left of the file.
+ */
+
+static bool queryIndex(FILE *fp, char **words, int numWords)
+{
+    char magic[MAGIC_SIZE], **names, *word = NULL;
+    uint32_t wflag, numFiles, *bases, numEntries, length, count, bytes, num;
+    struct query *queries;
+    unsigned char *data;
+    long long offset, dataStart, fileSize;
+    size_t size;
+    int i, k, lo, hi;
+
+
+    /* Read the names and first positions of the files.  Every count and
+       length must fit in the rest of the file: a file takes at least eight
+       bytes, a word twelve, and a list of N positions N / 128. */
+
+    if (fseek(fp, 0, SEEK_END) != 0 || (fileSize = ftell(fp)) < 0 || fseek(fp, 0, SEEK_SET) != 0)
+	return false;
+
+    if (fread(magic, 1, MAGIC_SIZE, fp) != MAGIC_SIZE || memcmp(magic, MAGIC, MAGIC_SIZE) != 0)
+	return false;
+
+    if (!getNumber(fp, &wflag) || !getNumber(fp, &numFiles))
+	return false;
+
+    if (numFiles == 0 || numFiles > bytesLeft(fp, fileSize) / 8)
+	return false;
+
+    names = malloc(numFiles * sizeof(char *));
+    bases = malloc(numFiles * sizeof(uint32_t));
+    assert(names != NULL && bases != NULL);
+
+    for (i = 0; i < numFiles; i ++) {
+	if (!getNumber(fp, &length) || length > bytesLeft(fp, fileSize))
+	    return false;
+
+	names[i] = malloc((size_t) length + 1);
+	assert(names[i] != NULL);
+
+	if (fread(names[i], 1, length, fp) != length || !getNumber(fp, &bases[i]))
+	    return false;
+
+	names[i][length] = '\0';
+    }
+
+
+    /* Find the words asked for in the dictionary. */
+
+    queries = calloc(numWords, sizeof(struct query));
+    assert(queries != NULL);
+
+    for (k = 0; k < numWords; k ++)
+	queries[k].word = words[k];
+
+    if (!getNumber(fp, &numEntries) || numEntries > bytesLeft(fp, fileSize) / 12)
+	return false;
+
+    offset = 0;
+    size = 0;
+
+    for (i = 0; i < numEntries; i ++) {
+	if (!getNumber(fp, &length) || length > bytesLeft(fp, fileSize))
+	    return false;
+
+	if ((size_t) length + 1 > size) {
+	    size = (size_t) length + 1;
+	    word = realloc(word, size);
+	    assert(word != NULL);
+	}
+
+	if (fread(word, 1, length, fp) != length || !getNumber(fp, &count) || !getNumber(fp, &bytes))
+	    return false;
+
+	if (bytes > bytesLeft(fp, fileSize) || count > (size_t) bytes * 128)
+	    return false;
+
+	word[length] = '\0';
+
+	for (k = 0; k < numWords; k ++)
+	    if (strcmp(word, queries[k].word) == 0) {
+		queries[k].found = true;
+		queries[k].count = count;
+		queries[k].length = bytes;
+		queries[k].offset = offset;
+	    }
+
+	offset += bytes;
+    }
+
+    free(word);
+    dataStart = ftell(fp);
+
+    if (offset > fileSize - dataStart)
+	return false;
+
+
+    /* Read and decode the posting list of each word. */
+
+    for (k = 0; k < numWords; k ++) {
+	if (!queries[k].found)
+	    break;
+
+	data = malloc(queries[k].length + 1);
+	assert(data != NULL);
+	fseek(fp, dataStart + queries[k].offset, SEEK_SET);
+
+	if (fread(data, 1, queries[k].length, fp) != queries[k].length)
+	    return false;
+
+	queries[k].positions = decodePostings(data, queries[k].length, queries[k].count);
+	free(data);
+
+	if (queries[k].positions == NULL)
+	    return false;
+    }
+
+
+    /* Keep the positions of the first word the other words follow. */
+
+    num = k == numWords ? queries[0].count : 0;
+
+    for (k = 1; k < numWords && num > 0; k ++)
+	num = matchPositions(queries[0].positions, num, queries[k].positions, queries[k].count, wflag ? k : 0);
+
+    for (i = 0; i < num; i ++) {
+	lo = 0;
+	hi = numFiles - 1;
+
+	while (lo < hi) {
+	    k = (lo + hi + 1) / 2;
+
+	    if (bases[k] <= queries[0].positions[i])
+		lo = k;
+	    else
+		hi = k - 1;
+	}
+
+	printf("%s:%lu\n", names[lo], (unsigned long) (queries[0].positions[i] - bases[lo] + 1));
+    }
+
+    for (k = 0; k < numWords; k ++)
+	free(queries[k].positions);
+
+    for (i = 0; i < numFiles; i ++)
+	free(names[i]);
+
+    free(queries);
+    free(names);
+    free(bases);
+    return true;
+}
+
+
+/*
+ * Function:    main
+ *
+ * Description: Driver function for the index application.
+ */
+
+int main(int argc, char *argv[])
+{
+    FILE *fp;
+    bool wflag = false;
+    int i;
+
+
+    /* Check usage and answer a query from an existing index. */
+
+    if (argc > 3 && strcmp(argv[1], "-q") == 0) {
+	if ((fp = fopen(argv[2], "rb")) == NULL) {
+	    fprintf(stderr, "%s: cannot open %s\n", argv[0], argv[2]);
+	    exit(EXIT_FAILURE);
+	}
+
+	if (!queryIndex(fp, argv + 3, argc - 3)) {
+	    fprintf(stderr, "%s: %s is not an index file\n", argv[0], argv[2]);
+	    exit(EXIT_FAILURE);
+	}
+
+	fclose(fp);
+	exit(EXIT_SUCCESS);
+    }
+
+    if (argc > 1 && strcmp(argv[1], "-w") == 0) {
+	wflag = true;
+	argc --;
+
+	for (i = 1; i < argc; i ++)
+	    argv[i] = argv[i + 1];
+    }
+
+    if (argc < 3 || argv[1][0] == '-') {
+	fprintf(stderr, "usage: %s [-w] indexfile file1 [file2 ...]\n", argv[0]);
+	fprintf(stderr, "       %s -q indexfile word1 [word2 ...]\n", argv[0]);
+	exit(EXIT_FAILURE);
+    }
+
+
+    /* Build the index. */
+
+    if (!buildIndex(argv[1], argv + 2, argc - 2, wflag)) {
+	fprintf(stderr, "%s: cannot write %s\n", argv[0], argv[1]);
+	exit(EXIT_FAILURE);
+    }
+
+    exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,178 @@
+/*
+ * File:        intbench.c
+ *
+ * Description: This file contains the main function for comparing the
+ *              integer set against the generic set used with integer
+ *              callbacks.
+ *
+ *              The program takes an optional number of keys as a command
+ *              line argument.  That many random 64-bit keys are inserted
+ *              into each set, then looked up along with as many keys that
+ *              are not in the set, and the time taken for each phase is
+ *              printed.
+ */
+
+# include <stdio.h>
+# include <stdlib.h>
+# include <stdint.h>
+# include <stdbool.h>
+# include <time.h>
+# include "set.h"
+# include "intset.h"
+
+
+# define DEFAULT_KEYS 1000000
+
+
+/*
+ * Function:    seconds
+ *
+ * Description: Return the current time in seconds.
+ */
+
+static double seconds(void)
+{
+    struct timespec ts;
+
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+/*
+ * Function:    nextKey
+ *
+ * Description: Return the next value from a splitmix64 generator.
+ */
+
+static uint64_t nextKey(uint64_t *state)
+{
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+
+
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return (z ^ (z >> 31)) >> 2;
+}
+
+
+/*
+ * Function:    hashKey
+ *
+ * Description: Return a hash value for a boxed integer key.
+ */
+
+static unsigned hashKey(uint64_t *kp)
+{
+    uint64_t k = *kp;
+
+
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    return (unsigned) k;
+}
+
+
+/*
+ * Function:    compareKeys
+ *
+ * Description: Compare two boxed integer keys.
+ */
+
+static int compareKeys(uint64_t *kp1, uint64_t *kp2)
+{
+    return *kp1 < *kp2 ? -1 : *kp1 > *kp2;
+}
+
+
+/*
+ * Function:    main
+ *
+ * Description: Driver function for the benchmark.
+ */
+
+int main(int argc, char *argv[])
+{
+    uint64_t *keys, state;
+    bool *found;
+    SET *generic;
+    INTSET *ints;
+    double start;
+    int i, n, hits;
+
+
+    n = argc > 1 ? atoi(argv[1]) : DEFAULT_KEYS;
+
+    if (argc > 2 || n <= 0) {
+        fprintf(stderr, "usage: %s [keys]\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+
+    /* The first half of the keys are inserted, the second half are not. */
+
+    keys = malloc(2 * n * sizeof(uint64_t));
+    found = malloc(2 * n * sizeof(bool));
+
+    if (keys == NULL || found == NULL) {
+        fprintf(stderr, "%s: out of memory\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    state = 12;
+
+    for (i = 0; i < 2 * n; i ++)
+	keys[i] = nextKey(&state);
+
+
+    /* Generic set with integer callbacks. */
+
+    generic = createSet(2 * n, compareKeys, hashKey);
+
+    start = seconds();
+
+    for (i = 0; i < n; i ++)
+	addElement(generic, &keys[i]);
+
+    printf("generic insert:  %.3f s\n", seconds() - start);
+
+    start = seconds();
+    hits = 0;
+
+    for (i = 0; i < 2 * n; i ++)
+	hits += findElement(generic, &keys[i]) != NULL;
+
+    printf("generic lookup:  %.3f s (%d hits)\n", seconds() - start, hits);
+    destroySet(generic);
+
+
+    /* Integer set, one key at a time and in bulk. */
+
+    ints = createIntSet(n);
+
+    start = seconds();
+
+    for (i = 0; i < n; i ++)
+	addInt(ints, keys[i]);
+
+    printf("intset insert:   %.3f s\n", seconds() - start);
+
+    start = seconds();
+    hits = 0;
+
+    for (i = 0; i < 2 * n; i ++)
+	hits += findInt(ints, keys[i]);
+
+    printf("intset lookup:   %.3f s (%d hits)\n", seconds() - start, hits);
+
+    start = seconds();
+    hits = findInts(ints, keys, 2 * n, found);
+    printf("intset bulk:     %.3f s (%d hits)\n", seconds() - start, hits);
+
+    destroyIntSet(ints);
+    free(found);
+    free(keys);
+    exit(EXIT_SUCCESS);
+}
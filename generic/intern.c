@@ -0,0 +1,156 @@
+//intern.c
+/**
+ * This file (intern.c) is an implementation for the string interner.
+ * A map from each word to its ID finds the ID of a word, and an array indexed by ID finds the word of an ID.
+ * The words themselves are copied once into the string arena of a pool, so interning a new word is a pointer bump.
+ * IDs are handed out in the order words are first seen and never change.
+ *
+ * @author Max Blennemann
+ * @version 10/18/26
+ */
+
+#include "intern.h"
+#include "map.h"
+#include "pool.h"
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#define MIN_WORDS 16 // Smallest size of the array of words
+
+typedef struct interner {
+    MAP* ids; // Maps each word to its ID
+    POOL* strings; // Holds the copy of every word
+    char** words; // The word of each ID
+    unsigned int count; // Number of words interned
+    unsigned int length; // How much space is allocated to words
+} stringInterner;
+
+/**
+ * Method given in lab documentation.
+ * Returns a hash value for the given string.
+ *
+ * @param s the string to get a hash for
+ * @return the hash value
+ * @timeComplexity O(N)
+ */
+static unsigned strhash(char* s) {
+    unsigned hash = 0;
+    while (*s != '\0')
+        hash = 31 * hash + *s++;
+    return hash;
+}
+
+/**
+ * Returns a new interner sized for the given number of distinct words.
+ * The interner grows as needed, so maxWords only needs to be an estimate.
+ *
+ * @param maxWords the number of distinct words expected
+ * @return the newly allocated interner
+ * @timeComplexity O(N) Where N is maxWords
+ */
+INTERNER* createInterner(int maxWords) {
+    assert(maxWords >= 0);
+    stringInterner* a = malloc(sizeof(stringInterner));
+    assert(a != NULL);
+    a->ids = createMap(maxWords * 4 / 3 + 1, sizeof(uint32_t), strcmp, strhash, NULL);
+    a->strings = createPool(0);
+    a->count = 0;
+    a->length = maxWords > MIN_WORDS ? maxWords : MIN_WORDS;
+    a->words = malloc(a->length * sizeof(char*));
+    assert(a->words != NULL);
+    return a;
+}
+
+/**
+ * Frees the interner and every word in it.
+ *
+ * @param ip the interner to destroy
+ * @timeComplexity O(1)
+ */
+void destroyInterner(INTERNER* ip) {
+    assert(ip != NULL);
+    destroyMap(ip->ids);
+    destroyPool(ip->strings);
+    free(ip->words);
+    free(ip);
+}
+
+/**
+ * Returns the number of distinct words interned, which is also one more than the largest ID.
+ *
+ * @param ip the interner to access
+ * @return the number of words
+ * @timeComplexity O(1)
+ */
+int numWords(INTERNER* ip) {
+    assert(ip != NULL);
+    return ip->count;
+}
+
+/**
+ * Returns the ID of a word, giving it the next ID if it has not been interned before.
+ * The word is copied, so the caller may reuse its buffer.
+ *
+ * @param ip the interner to add the word to
+ * @param word the word to intern
+ * @return the ID of the word
+ * @timeComplexity O(N) worst case; O(1) amortized average case
+ */
+uint32_t internWord(INTERNER* ip, char* word) {
+    assert(ip != NULL);
+    assert(word != NULL);
+    uint32_t* idp = getValue(ip->ids, word);
+    if (idp != NULL)
+        return *idp;
+    assert(ip->count < NO_WORD);
+    if (ip->count == ip->length) {
+        ip->length *= 2;
+        ip->words = realloc(ip->words, ip->length * sizeof(char*));
+        assert(ip->words != NULL);
+    }
+    uint32_t id = ip->count++;
+    ip->words[id] = allocString(ip->strings, word, strlen(word));
+    putValue(ip->ids, ip->words[id], &id);
+    return id;
+}
+
+/**
+ * Returns the ID of a word without interning it.
+ *
+ * @param ip the interner to search through
+ * @param word the word to search for
+ * @return the ID of the word, or NO_WORD if it has not been interned
+ * @timeComplexity O(N) worst case; O(1) average case
+ */
+uint32_t findWordId(INTERNER* ip, char* word) {
+    assert(ip != NULL);
+    uint32_t* idp = getValue(ip->ids, word);
+    return idp != NULL ? *idp : NO_WORD;
+}
+
+/**
+ * Returns the word with the given ID.
+ *
+ * @param ip the interner to access
+ * @param id the ID of the word
+ * @return the word, which stays valid until the interner is destroyed
+ * @timeComplexity O(1)
+ */
+char* wordOf(INTERNER* ip, uint32_t id) {
+    assert(ip != NULL);
+    assert(id < ip->count);
+    return ip->words[id];
+}
+
+/**
+ * Returns the array of words indexed by ID.
+ * The array belongs to the interner and is only valid until the next word is interned.
+ *
+ * @param ip the interner to access
+ * @return the array of numWords(ip) words
+ * @timeComplexity O(1)
+ */
+char** getWords(INTERNER* ip) {
+    assert(ip != NULL);
+    return ip->words;
+}
@@ -0,0 +1,34 @@
+/*
+ * File:        intern.h
+ *
+ * Description: This file contains the public function and type
+ *              declarations for a string interner.  Each distinct word
+ *              interned is given a stable, dense integer ID starting at
+ *              zero, so later stages can work with flat arrays and bitsets
+ *              indexed by ID instead of hashing strings again.
+ */
+
+# ifndef INTERN_H
+# define INTERN_H
+
+# include <stdint.h>
+
+# define NO_WORD UINT32_MAX
+
+typedef struct interner INTERNER;
+
+INTERNER *createInterner(int maxWords);
+
+void destroyInterner(INTERNER *ip);
+
+int numWords(INTERNER *ip);
+
+uint32_t internWord(INTERNER *ip, char *word);
+
+uint32_t findWordId(INTERNER *ip, char *word);
+
+char *wordOf(INTERNER *ip, uint32_t id);
+
+char **getWords(INTERNER *ip);
+
+# endif /* INTERN_H */
@@ -0,0 +1,277 @@
+//intset.c
+/**
+ * This file (intset.c) is an implementation of a set of integer keys.
+ * It is a specialization of generic/table.c for 32 and 64-bit IDs.
+ * Keys are stored inline in the slot array instead of behind a void* pointer,
+ * and the hash is a built in integer mixer instead of a user given function.
+ * Empty and deleted slots are marked with reserved key values, so no flags array is needed.
+ * Slots are probed in groups of four so a whole group can be compared at once with SIMD instructions.
+ *
+ * @author Max Blennemann
+ * @version 10/18/26
+ */
+
+#include "intset.h"
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#define GROUP 4 // Number of slots compared at once
+#define BATCH 16 // Number of keys hashed and prefetched ahead in findInts
+
+typedef struct intset {
+    uint64_t* data; // INTSET_EMPTY = empty, INTSET_DELETED = deleted
+    unsigned int count; // Number of elements that contain data
+    unsigned int maxElts; // Number of elements the set was created to hold
+    unsigned int groups; // Number of groups of slots, always a power of two
+} intTable;
+
+/**
+ * Returns a hash value for the given key.
+ * This is the finalizer of MurmurHash3, which mixes every input bit into every output bit.
+ *
+ * @param key the key to get a hash for
+ * @return the hash value
+ * @timeComplexity O(1)
+ */
+static inline uint64_t intHash(uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    key ^= key >> 33;
+    return key;
+}
+
+/**
+ * Returns a bit mask of the slots in a group that hold the given key.
+ * Bit i is set if slot i of the group matches.
+ *
+ * @param group the first slot of the group
+ * @param key the key to compare against
+ * @return the mask of matching slots
+ * @timeComplexity O(1)
+ */
+static inline unsigned matchGroup(const uint64_t* group, uint64_t key) {
+#ifdef __SSE2__
+    __m128i k = _mm_set1_epi64x((long long) key);
+    __m128i lo = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*) group), k);
+    __m128i hi = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*) (group + 2)), k);
+    // SSE2 has no 64-bit compare, so both 32-bit halves must match
+    lo = _mm_and_si128(lo, _mm_shuffle_epi32(lo, _MM_SHUFFLE(2, 3, 0, 1)));
+    hi = _mm_and_si128(hi, _mm_shuffle_epi32(hi, _MM_SHUFFLE(2, 3, 0, 1)));
+    return (unsigned) _mm_movemask_pd(_mm_castsi128_pd(lo)) |
+           (unsigned) _mm_movemask_pd(_mm_castsi128_pd(hi)) << 2;
+#else
+    unsigned mask = 0;
+    unsigned i = 0;
+    for (; i < GROUP; i++)
+        if (group[i] == key)
+            mask |= 1u << i;
+    return mask;
+#endif
+}
+
+/**
+ * Returns a new set with the specified number of elements as the maximum capacity.
+ * At least twice as many slots are allocated so probe sequences stay short.
+ *
+ * @param maxElts the maximum amount of elements the set can hold
+ * @return the newly allocated set
+ * @timeComplexity O(N) Where N is the maximum number of elements the set can hold (maxElts)
+ */
+INTSET* createIntSet(int maxElts) {
+    assert(maxElts >= 0);
+    intTable* a = malloc(sizeof(intTable));
+    assert(a != NULL);
+    a->count = 0;
+    a->maxElts = maxElts;
+    a->groups = 1;
+    while (a->groups * GROUP < 2 * (unsigned) maxElts)
+        a->groups <<= 1;
+    a->data = malloc(a->groups * GROUP * sizeof(uint64_t));
+    assert(a->data != NULL);
+    memset(a->data, 0xff, a->groups * GROUP * sizeof(uint64_t)); // every byte 0xff is INTSET_EMPTY
+    return a;
+}
+
+/**
+ * Frees the memory allocated to the set.
+ *
+ * @param sp the set to destroy
+ * @timeComplexity O(1)
+ */
+void destroyIntSet(INTSET* sp) {
+    assert(sp != NULL);
+    free(sp->data);
+    free(sp);
+}
+
+/**
+ * Returns the number of elements in the set
+ *
+ * @param sp the set to access
+ * @return the number of unique elements
+ * @timeComplexity O(1)
+ */
+int numInts(INTSET* sp) {
+    assert(sp != NULL);
+    return sp->count;
+}
+
+/**
+ * Finds the slot of a key in the set given the hash of the key.
+ * Returns the slot the key would go in if the key is not found,
+ * preferring the first deleted slot on the probe sequence.
+ *
+ * @param sp the set to search through
+ * @param key the key to search for
+ * @param hash the value of intHash(key)
+ * @param found set to whether the key was found
+ * @return the slot where the key is or should be added
+ * @timeComplexity O(N) worst case; O(1) average case
+ */
+static unsigned findIntIndex(INTSET* sp, uint64_t key, uint64_t hash, bool* found) {
+    unsigned const mask = sp->groups - 1;
+    unsigned group = hash & mask;
+    unsigned firstDeleted = sp->groups * GROUP;
+    unsigned probes = 0;
+    for (; probes < sp->groups; probes++) {
+        uint64_t const* g = sp->data + group * GROUP;
+        unsigned m = matchGroup(g, key);
+        if (m != 0) {
+            *found = true;
+            return group * GROUP + __builtin_ctz(m);
+        }
+        if (firstDeleted == sp->groups * GROUP && (m = matchGroup(g, INTSET_DELETED)) != 0)
+            firstDeleted = group * GROUP + __builtin_ctz(m);
+        if ((m = matchGroup(g, INTSET_EMPTY)) != 0) {
+            *found = false;
+            if (firstDeleted != sp->groups * GROUP)
+                return firstDeleted;
+            return group * GROUP + __builtin_ctz(m);
+        }
+        group = (group + 1) & mask;
+    }
+    *found = false;
+    return firstDeleted;
+}
+
+/**
+ * Adds a new key to the set.
+ * The reserved values INTSET_EMPTY and INTSET_DELETED may not be added.
+ *
+ * @param sp the set to add a key to
+ * @param key the key to add
+ * @timeComplexity O(N) worst case; O(1) average case
+ */
+void addInt(INTSET* sp, uint64_t key) {
+    assert(sp != NULL);
+    assert(key != INTSET_EMPTY && key != INTSET_DELETED);
+    assert(sp->count < sp->maxElts);
+    bool alreadyExists = false;
+    unsigned index = findIntIndex(sp, key, intHash(key), &alreadyExists);
+    if (alreadyExists)
+        return;
+    sp->data[index] = key;
+    sp->count++;
+}
+
+/**
+ * Removes a key from the set.
+ * This function will silently fail if the key does not exist.
+ *
+ * @param sp the set to remove the key from
+ * @param key the key to remove
+ * @timeComplexity O(N) worst case; O(1) average case
+ */
+void removeInt(INTSET* sp, uint64_t key) {
+    assert(sp != NULL);
+    if (key == INTSET_EMPTY || key == INTSET_DELETED)
+        return;
+    bool found = false;
+    unsigned index = findIntIndex(sp, key, intHash(key), &found);
+    if (found == false)
+        return;
+    sp->data[index] = INTSET_DELETED;
+    sp->count--;
+}
+
+/**
+ * Returns whether the key is in the set.
+ *
+ * @param sp the set to search through
+ * @param key the key to search for
+ * @return true if the key is in the set
+ * @timeComplexity O(N) worst case; O(1) average case
+ */
+bool findInt(INTSET* sp, uint64_t key) {
+    assert(sp != NULL);
+    if (key == INTSET_EMPTY || key == INTSET_DELETED)
+        return false;
+    bool found = false;
+    findIntIndex(sp, key, intHash(key), &found);
+    return found;
+}
+
+/**
+ * Looks up many keys at once and stores whether each was found in found[i].
+ * The keys are hashed and their first groups prefetched a batch at a time,
+ * so the cache misses of a batch overlap instead of being paid one after another.
+ *
+ * @param sp the set to search through
+ * @param keys the keys to search for
+ * @param n the number of keys
+ * @param found an array of n booleans to fill in
+ * @return the number of keys that were found
+ * @timeComplexity O(n) average case
+ */
+int findInts(INTSET* sp, const uint64_t* keys, int n, bool* found) {
+    assert(sp != NULL);
+    assert(n == 0 || (keys != NULL && found != NULL));
+    uint64_t hashes[BATCH];
+    int hits = 0;
+    int start = 0;
+    for (; start < n; start += BATCH) {
+        int end = start + BATCH < n ? start + BATCH : n;
+        int i = start;
+        for (; i < end; i++) {
+            hashes[i - start] = intHash(keys[i]);
+            __builtin_prefetch(sp->data + (hashes[i - start] & (sp->groups - 1)) * GROUP);
+        }
+        for (i = start; i < end; i++) {
+            if (keys[i] == INTSET_EMPTY || keys[i] == INTSET_DELETED)
+                found[i] = false;
+            else
+                findIntIndex(sp, keys[i], hashes[i - start], &found[i]);
+            hits += found[i];
+        }
+    }
+    return hits;
+}
+
+/**
+ * Copies all the keys in the set to a new array and returns that new array.
+ * The user must free the array before exiting to avoid a memory leak.
+ * The returned array is not guaranteed to be sorted in any way.
+ *
+ * @param sp The set to access
+ * @return A new array of the keys in the set
+ * @timeComplexity O(N)
+ */
+uint64_t* getInts(INTSET* sp) {
+    assert(sp != NULL);
+    uint64_t* toReturn = malloc(sp->count * sizeof(uint64_t));
+    assert(toReturn != NULL || sp->count == 0);
+    unsigned whereToAdd = 0;
+    unsigned i = 0;
+    for (; i < sp->groups * GROUP; i++) {
+        if (sp->data[i] != INTSET_EMPTY && sp->data[i] != INTSET_DELETED) {
+            toReturn[whereToAdd] = sp->data[i];
+            whereToAdd++;
+        }
+    }
+    return toReturn;
+}
@@ -0,0 +1,38 @@
+/*
+ * File:        intset.h
+ *
+ * Description: This file contains the public function and type
+ *              declarations for a set abstract data type specialized for
+ *              32 and 64-bit integer keys.  Keys are stored inline, so
+ *              no hash or comparison functions are needed.  The two
+ *              largest 64-bit values are reserved and may not be stored.
+ */
+
+# ifndef INTSET_H
+# define INTSET_H
+
+# include <stdint.h>
+# include <stdbool.h>
+
+# define INTSET_EMPTY	UINT64_MAX
+# define INTSET_DELETED	(UINT64_MAX - 1)
+
+typedef struct intset INTSET;
+
+INTSET *createIntSet(int maxElts);
+
+void destroyIntSet(INTSET *sp);
+
+int numInts(INTSET *sp);
+
+void addInt(INTSET *sp, uint64_t key);
+
+void removeInt(INTSET *sp, uint64_t key);
+
+bool findInt(INTSET *sp, uint64_t key);
+
+int findInts(INTSET *sp, const uint64_t *keys, int n, bool *found);
+
+uint64_t *getInts(INTSET *sp);
+
+# endif /* INTSET_H */
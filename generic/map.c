@@ -0,0 +1,313 @@
+//map.c
+/**
+ * This file (map.c) is an implementation for the map data type.
+ * It uses the same open addressing and linear probing scheme as generic/table.c,
+ * but every slot also holds a fixed-size value stored inline in a parallel array.
+ * This lets drivers such as counts.c keep a count per key without allocating a record for each key.
+ * The map guarantees no duplicate keys.
+ *
+ * @author Max Blennemann
+ * @version 10/18/26
+ */
+
+#include "map.h"
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#define EMPTY 'e'
+#define FILLED 'f'
+#define DELETED 'd'
+#define MIN_SIZE 16 // Smallest size the map grows to
+
+typedef struct map {
+    void** keys;
+    char* values; // valueSize bytes for each slot
+    char* flags; // 'e' = empty, 'f' = filled, 'd' = deleted
+    unsigned int count; // Number of slots that contain data
+    unsigned int deleted; // Number of slots marked as deleted
+    unsigned int size; // How much space is allocated to the arrays
+    size_t valueSize; // Size in bytes of a single value
+
+    int (* compare)(); //Method passed in from createMap that compares two keys
+
+    unsigned (* hash)(); //Method passed in from createMap that hashes a key
+
+    void* (* copyKey)(); //Method passed in from createMap that copies a new key, or NULL to store the key as given
+} genericMap;
+
+/**
+ * Returns a new map with the specified number of keys as the initial capacity.
+ * The map grows when it is three quarters full, so maxElts should be about 4/3 of the expected number of keys.
+ *
+ * @param maxElts the initial amount of keys the map can hold
+ * @param valueSize the size in bytes of the value stored with each key
+ * @param compare compares two keys as in strcmp()
+ * @param hash returns a hash value for a key
+ * @param copyKey returns a copy of a key being added, or NULL to store keys as given
+ * @return the newly allocated map
+ * @timeComplexity O(N) Where N is the maximum number of keys the map can hold (maxElts)
+ */
+MAP* createMap(int maxElts, size_t valueSize, int (* compare)(), unsigned (* hash)(), void* (* copyKey)()) {
+    assert(maxElts >= 0);
+    assert(compare != NULL && hash != NULL);
+    genericMap* a = malloc(sizeof(genericMap));
+    assert(a != NULL);
+    a->compare = compare;
+    a->hash = hash;
+    a->copyKey = copyKey;
+    a->count = 0;
+    a->deleted = 0;
+    a->size = maxElts;
+    a->valueSize = valueSize;
+    a->keys = malloc(maxElts * sizeof(void*));
+    a->values = malloc(maxElts * valueSize);
+    a->flags = malloc(maxElts * sizeof(char));
+    assert(a->keys != NULL);
+    assert(a->values != NULL || valueSize == 0);
+    assert(a->flags != NULL);
+    memset(a->flags, EMPTY, maxElts);
+    return a;
+}
+
+/**
+ * Frees the memory allocated to the map.
+ * The keys are owned by the caller and are not freed.
+ *
+ * @param mp the map to destroy
+ * @timeComplexity O(1)
+ */
+void destroyMap(MAP* mp) {
+    assert(mp != NULL);
+    free(mp->keys);
+    free(mp->values);
+    free(mp->flags);
+    free(mp);
+}
+
+/**
+ * Returns the number of keys in the map
+ *
+ * @param mp the map to access
+ * @return the number of unique keys
+ * @timeComplexity O(1)
+ */
+int numEntries(MAP* mp) {
+    assert(mp != NULL);
+    return mp->count;
+}
+
+/**
+ * Finds the index of a key in the map.
+ * Returns the location the key would go if the key is not found.
+ * Returns mp->size if the key can't be added.
+ *
+ * @param mp the map to search through
+ * @param key the key to search for
+ * @param found set to whether the key was found
+ * @return the index where the key is or should be added
+ * @timeComplexity (O(N) + user given hash function) worst case; (O(1) + user given hash function) average case
+ */
+static unsigned int findKeyIndex(MAP* mp, void* key, bool* found) {
+    assert(key != NULL);
+    unsigned firstDeleted = mp->size;
+    if (mp->size == 0) {
+        *found = false;
+        return firstDeleted;
+    }
+    unsigned const home = (*mp->hash)(key) % mp->size;
+    unsigned index = home;
+    do {
+        if (mp->flags[index] == EMPTY) {
+            *found = false;
+            return firstDeleted != mp->size ? firstDeleted : index;
+        } else if (mp->flags[index] == FILLED && (*mp->compare)(mp->keys[index], key) == 0) {
+            *found = true;
+            return index;
+        } else if (mp->flags[index] == DELETED && firstDeleted == mp->size)
+            firstDeleted = index;
+        index = (index + 1) % mp->size;
+    } while (index != home);
+    *found = false;
+    return firstDeleted;
+}
+
+/**
+ * Returns a pointer to the value stored with a key.
+ * The pointer is valid until the key is removed or the map is destroyed.
+ *
+ * @param mp the map to search through
+ * @param key the key to search for
+ * @return a pointer to the value, or NULL if the key is not in the map
+ * @timeComplexity O(N) worst case; O(1) average case
+ */
+void* getValue(MAP* mp, void* key) {
+    assert(mp != NULL);
+    if (key == NULL)
+        return NULL;
+    bool found = false;
+    unsigned index = findKeyIndex(mp, key, &found);
+    if (found == false)
+        return NULL;
+    return mp->values + index * mp->valueSize;
+}
+
+/**
+ * Moves every key and value of the map into newly allocated arrays of the given size.
+ * Deleted slots are dropped, so this also clears out deleted markers when newSize equals the current size.
+ *
+ * @param mp the map to resize
+ * @param newSize the new number of slots, which must be larger than the number of keys
+ * @timeComplexity O(N + newSize)
+ */
+static void resizeMap(MAP* mp, unsigned newSize) {
+    assert(newSize > mp->count);
+    void** oldKeys = mp->keys;
+    char* oldValues = mp->values;
+    char* oldFlags = mp->flags;
+    unsigned oldSize = mp->size;
+    mp->keys = malloc(newSize * sizeof(void*));
+    mp->values = malloc(newSize * mp->valueSize);
+    mp->flags = malloc(newSize * sizeof(char));
+    assert(mp->keys != NULL);
+    assert(mp->values != NULL || mp->valueSize == 0);
+    assert(mp->flags != NULL);
+    memset(mp->flags, EMPTY, newSize);
+    mp->size = newSize;
+    mp->deleted = 0;
+    unsigned i = 0;
+    for (; i < oldSize; i++) {
+        if (oldFlags[i] == FILLED) {
+            unsigned index = (*mp->hash)(oldKeys[i]) % newSize;
+            while (mp->flags[index] != EMPTY)
+                index = (index + 1) % newSize;
+            mp->keys[index] = oldKeys[i];
+            mp->flags[index] = FILLED;
+            memcpy(mp->values + index * mp->valueSize, oldValues + i * mp->valueSize, mp->valueSize);
+        }
+    }
+    free(oldKeys);
+    free(oldValues);
+    free(oldFlags);
+}
+
+/**
+ * Returns a pointer to the value stored with a key, adding the key if it is not in the map.
+ * The value of a newly added key is zero filled.
+ *
+ * @param mp the map to add the key to
+ * @param key the key to search for or add
+ * @param inserted if not NULL, set to whether the key was added
+ * @return a pointer to the value of the key
+ * @timeComplexity O(N) worst case; O(1) amortized average case
+ */
+void* upsertValue(MAP* mp, void* key, bool* inserted) {
+    assert(mp != NULL);
+    assert(key != NULL);
+    bool found = false;
+    unsigned index = findKeyIndex(mp, key, &found);
+    if (inserted != NULL)
+        *inserted = !found;
+    if (!found && 4 * (mp->count + mp->deleted + 1) > 3 * mp->size) {
+        if (4 * (mp->count + 1) > 2 * mp->size)
+            resizeMap(mp, mp->size * 2 > MIN_SIZE ? mp->size * 2 : MIN_SIZE);
+        else
+            resizeMap(mp, mp->size); // mostly deleted slots, so just clear them out
+        index = findKeyIndex(mp, key, &found);
+    }
+    if (!found) {
+        if (mp->flags[index] == DELETED)
+            mp->deleted--;
+        mp->keys[index] = mp->copyKey != NULL ? (*mp->copyKey)(key) : key;
+        assert(mp->keys[index] != NULL);
+        mp->flags[index] = FILLED;
+        mp->count++;
+        memset(mp->values + index * mp->valueSize, 0, mp->valueSize);
+    }
+    return mp->values + index * mp->valueSize;
+}
+
+/**
+ * Stores a copy of the value with a key, adding the key if it is not in the map.
+ *
+ * @param mp the map to add the key to
+ * @param key the key to store the value with
+ * @param value a pointer to valueSize bytes to copy into the map
+ * @timeComplexity O(N) worst case; O(1) average case
+ */
+void putValue(MAP* mp, void* key, void* value) {
+    assert(value != NULL);
+    memcpy(upsertValue(mp, key, NULL), value, mp->valueSize);
+}
+
+/**
+ * Adds delta to the int value of a key, adding the key with a value of zero first if needed.
+ * The map must have been created with a valueSize of at least sizeof(int).
+ *
+ * @param mp the map to add the key to
+ * @param key the key whose value is incremented
+ * @param delta the amount to add
+ * @return the new value of the key
+ * @timeComplexity O(N) worst case; O(1) average case
+ */
+int incrementValue(MAP* mp, void* key, int delta) {
+    assert(mp != NULL);
+    assert(mp->valueSize >= sizeof(int));
+    int* vp = upsertValue(mp, key, NULL);
+    *vp += delta;
+    return *vp;
+}
+
+/**
+ * Removes a key and its value from the map.
+ * This function will silently fail if the key does not exist.
+ *
+ * @param mp the map to remove the key from
+ * @param key the key to remove
+ * @timeComplexity O(N) worst case; O(1) average case
+ */
+void removeKey(MAP* mp, void* key) {
+    assert(mp != NULL);
+    if (key != NULL) {
+        bool found = false;
+        unsigned index = findKeyIndex(mp, key, &found);
+        if (found == false)
+            return;
+        mp->flags[index] = DELETED;
+        mp->count--;
+        mp->deleted++;
+    }
+}
+
+/**
+ * Removes every key and value from the map but keeps its arrays, so a map that is refilled
+ * over and over, such as one bucket of a sliding window, is not allocated again each time.
+ * The keys are owned by the caller and are not freed.
+ *
+ * @param mp the map to empty
+ * @timeComplexity O(N) Where N is the number of slots in the map
+ */
+void clearMap(MAP* mp) {
+    assert(mp != NULL);
+    memset(mp->flags, EMPTY, mp->size);
+    mp->count = 0;
+    mp->deleted = 0;
+}
+
+/**
+ * Calls visit(key, value, arg) for every key in the map, where value points to the stored value.
+ * The visit function may change the value but must not add or remove keys.
+ * The keys are not visited in any particular order.
+ *
+ * @param mp the map to access
+ * @param visit the function to call for each key
+ * @param arg passed through to visit
+ * @timeComplexity O(N)
+ */
+void forEachEntry(MAP* mp, void (* visit)(), void* arg) {
+    assert(mp != NULL);
+    assert(visit != NULL);
+    unsigned i = 0;
+    for (; i < mp->size; i++)
+        if (mp->flags[i] == FILLED)
+            (*visit)(mp->keys[i], mp->values + i * mp->valueSize, arg);
+}
@@ -0,0 +1,41 @@
+/*
+ * File:        map.h
+ *
+ * Description: This file contains the public function and type
+ *              declarations for a map abstract data type for generic
+ *              pointer keys.  A map is an unordered collection of distinct
+ *              keys, each with a fixed-size value stored inline in the
+ *              map.  Keys are owned by the caller; if a copy function is
+ *              given it is used to copy each key when it is first added.
+ */
+
+# ifndef MAP_H
+# define MAP_H
+
+# include <stddef.h>
+# include <stdbool.h>
+
+typedef struct map MAP;
+
+MAP *createMap(int maxElts, size_t valueSize,
+	int (*compare)(), unsigned (*hash)(), void *(*copyKey)());
+
+void destroyMap(MAP *mp);
+
+int numEntries(MAP *mp);
+
+void *getValue(MAP *mp, void *key);
+
+void putValue(MAP *mp, void *key, void *value);
+
+int incrementValue(MAP *mp, void *key, int delta);
+
+void *upsertValue(MAP *mp, void *key, bool *inserted);
+
+void removeKey(MAP *mp, void *key);
+
+void clearMap(MAP *mp);
+
+void forEachEntry(MAP *mp, void (*visit)(), void *arg);
+
+# endif /* MAP_H */
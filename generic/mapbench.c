@@ -0,0 +1,279 @@
+/*
+ * File:        mapbench.c
+ *
+ * Description: This file contains the main function for comparing the
+ *              map against the set of entry records that counts used
+ *              before it, with the words already in memory so only the
+ *              table work is timed.
+ *
+ *              The program takes a text file and an optional number of
+ *              passes as command line arguments.  The words of the file
+ *              are read once, then counted in each pass by a set of
+ *              allocated word and count records, looked up and added as
+ *              counts did, and by a map with inline counts whose keys are
+ *              copied into a pool.  The best time of each, the mallocs
+ *              for records, and the number of distinct words are printed.
+ */
+
+# include <stdio.h>
+# include <stdlib.h>
+# include <string.h>
+# include <assert.h>
+# include <time.h>
+# include "set.h"
+# include "map.h"
+# include "pool.h"
+# include "tokenizer.h"
+
+
+# define DEFAULT_PASSES 5
+# define MAX_SIZE 18000
+
+struct entry {
+    char *word;
+    int count;
+};
+
+
+/* The copies of the distinct words in the map, freed after each pass. */
+
+static POOL *copies;
+
+
+/*
+ * Function:    seconds
+ *
+ * Description: Return the current time in seconds.
+ */
+
+static double seconds(void)
+{
+    struct timespec ts;
+
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+/*
+ * Function:    strhash
+ *
+ * Description: Return a hash value for a string S.
+ */
+
+static unsigned strhash(char *s)
+{
+    unsigned hash = 0;
+
+
+    while (*s != '\0')
+        hash = 31 * hash + *s ++;
+
+    return hash;
+}
+
+
+/*
+ * Function:	hashEntry
+ *
+ * Description:	Return a hash value for an entry based on its word.
+ */
+
+static unsigned hashEntry(struct entry *ep)
+{
+    return strhash(ep->word);
+}
+
+
+/*
+ * Function:	compareEntries
+ *
+ * Description:	Compare two entries as in strcmp().
+ */
+
+static int compareEntries(struct entry *ep1, struct entry *ep2)
+{
+    return strcmp(ep1->word, ep2->word);
+}
+
+
+/*
+ * Function:	copyWord
+ *
+ * Description:	Return a copy of a word being added to the map.
+ */
+
+static void *copyWord(char *word)
+{
+    return allocString(copies, word, strlen(word));
+}
+
+
+/*
+ * Function:	countEntries
+ *
+ * Description:	Count the N words in WORDS with a set of entry records,
+ *		and return the number of mallocs for records.  The time
+ *		taken is stored in ELAPSED.
+ */
+
+static long countEntries(char **words, int n, double *elapsed)
+{
+    struct entry e, *ep, **entries;
+    SET *counts;
+    double start;
+    long records;
+    int i;
+
+
+    start = seconds();
+    counts = createSet(MAX_SIZE, compareEntries, hashEntry);
+    records = 0;
+
+    for (i = 0; i < n; i ++) {
+	e.word = words[i];
+	ep = findElement(counts, &e);
+
+	if (ep == NULL) {
+	    ep = malloc(sizeof(struct entry));
+	    assert(ep != NULL);
+
+	    ep->word = strdup(words[i]);
+	    assert(ep->word != NULL);
+
+	    ep->count = 1;
+	    addElement(counts, ep);
+	    records += 2;
+
+	} else
+	    ep->count ++;
+    }
+
+    *elapsed = seconds() - start;
+
+    entries = getElements(counts);
+
+    for (i = 0; i < numElements(counts); i ++) {
+	free(entries[i]->word);
+	free(entries[i]);
+    }
+
+    free(entries);
+    destroySet(counts);
+    return records;
+}
+
+
+/*
+ * Function:	countMap
+ *
+ * Description:	Count the N words in WORDS with a map, and return the
+ *		number of distinct words.  The time taken is stored in
+ *		ELAPSED.
+ */
+
+static int countMap(char **words, int n, double *elapsed)
+{
+    MAP *counts;
+    double start;
+    int i, distinct;
+
+
+    start = seconds();
+    copies = createPool(0);
+    counts = createMap(MAX_SIZE, sizeof(int), strcmp, strhash, copyWord);
+
+    for (i = 0; i < n; i ++)
+	incrementValue(counts, words[i], 1);
+
+    *elapsed = seconds() - start;
+
+    distinct = numEntries(counts);
+    destroyMap(counts);
+    destroyPool(copies);
+    return distinct;
+}
+
+
+/*
+ * Function:    main
+ *
+ * Description: Driver function for the benchmark.
+ */
+
+int main(int argc, char *argv[])
+{
+    FILE *fp;
+    TOKENIZER *tp;
+    struct token tok;
+    POOL *text;
+    char **words;
+    double elapsed, entryTime, mapTime;
+    long records;
+    int i, n, size, passes, distinct;
+
+
+    passes = argc > 2 ? atoi(argv[2]) : DEFAULT_PASSES;
+
+    if (argc < 2 || argc > 3 || passes <= 0) {
+        fprintf(stderr, "usage: %s file [passes]\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    if ((fp = fopen(argv[1], "r")) == NULL) {
+        fprintf(stderr, "%s: cannot open %s\n", argv[0], argv[1]);
+        exit(EXIT_FAILURE);
+    }
+
+
+    /* Read every word into memory first. */
+
+    text = createPool(0);
+    tp = createTokenizer(fp);
+    words = NULL;
+    size = 0;
+
+    for (n = 0; nextToken(tp, &tok); n ++) {
+	if (n == size) {
+	    size = size > 0 ? size * 2 : 1024;
+	    words = realloc(words, size * sizeof(char *));
+	    assert(words != NULL);
+	}
+
+	words[n] = allocString(text, tok.text, tok.length);
+    }
+
+    destroyTokenizer(tp);
+    fclose(fp);
+
+
+    /* Alternate the two methods and keep the best time of each. */
+
+    entryTime = mapTime = 0;
+    records = 0;
+    distinct = 0;
+
+    for (i = 0; i < passes; i ++) {
+	records = countEntries(words, n, &elapsed);
+
+	if (i == 0 || elapsed < entryTime)
+	    entryTime = elapsed;
+
+	distinct = countMap(words, n, &elapsed);
+
+	if (i == 0 || elapsed < mapTime)
+	    mapTime = elapsed;
+    }
+
+    printf("%d words, %d distinct, best of %d passes\n", n, distinct, passes);
+    printf("entry set: %8.3f s %8.1f M words/s  %ld mallocs\n",
+	entryTime, n / entryTime / 1e6, records);
+    printf("map:       %8.3f s %8.1f M words/s  no mallocs per word\n",
+	mapTime, n / mapTime / 1e6);
+    printf("speedup:   %8.2fx\n", entryTime / mapTime);
+
+    free(words);
+    destroyPool(text);
+    exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,169 @@
+//minhash.c
+/**
+ * This file (minhash.c) is an implementation of one-permutation MinHash signatures.
+ * Classic MinHash hashes every word k times and keeps the k minimums; one-permutation hashing hashes each word once,
+ * uses the top bits of the hash to pick one of k bins, and keeps the minimum hash seen in each bin.
+ * Adding a word is therefore O(1) no matter how many bins the signature has.
+ * A bin no word fell in is filled by finishSignature with the value of a filled bin picked by hashing,
+ * so two signatures can be compared bin by bin: the fraction of equal bins estimates the Jaccard similarity.
+ *
+ * @author Max Blennemann
+ * @version 10/18/26
+ */
+
+#include "minhash.h"
+#include <stdlib.h>
+#include <stdbool.h>
+#include <assert.h>
+#define EMPTY_BIN UINT64_MAX // Marks a bin no word has fallen in
+
+typedef struct signature {
+    uint64_t* bins; // Smallest hash seen in each bin
+    int numBins; // Number of bins
+    bool finished; // Whether finishSignature has filled the empty bins
+} oneHashSignature;
+
+/**
+ * Returns a 64-bit hash value for a word given the tokenizer's 32-bit hash and the word's length.
+ * The MurmurHash3 finalizer is applied so the top bits, which pick the bin, depend on every input bit.
+ *
+ * @param hash the 32-bit hash of the word
+ * @param length the length of the word
+ * @return the mixed hash value
+ * @timeComplexity O(1)
+ */
+static inline uint64_t mixHash(unsigned hash, size_t length) {
+    uint64_t key = (uint64_t) length << 32 | hash;
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    key ^= key >> 33;
+    return key;
+}
+
+/**
+ * Returns a new empty signature with the given number of bins.
+ * More bins give a more accurate estimate; the standard error of the estimate is about 1 / sqrt(bins).
+ *
+ * @param bins the number of bins
+ * @return the newly allocated signature
+ * @timeComplexity O(bins)
+ */
+SIGNATURE* createSignature(int bins) {
+    assert(bins > 0);
+    oneHashSignature* a = malloc(sizeof(oneHashSignature));
+    assert(a != NULL);
+    a->numBins = bins;
+    a->finished = false;
+    a->bins = malloc(bins * sizeof(uint64_t));
+    assert(a->bins != NULL);
+    int i = 0;
+    for (; i < bins; i++)
+        a->bins[i] = EMPTY_BIN;
+    return a;
+}
+
+/**
+ * Frees the memory allocated to the signature.
+ *
+ * @param sp the signature to destroy
+ * @timeComplexity O(1)
+ */
+void destroySignature(SIGNATURE* sp) {
+    assert(sp != NULL);
+    free(sp->bins);
+    free(sp);
+}
+
+/**
+ * Adds a word to the signature. Adding the same word again has no effect.
+ *
+ * @param sp the signature to add to
+ * @param hash the hash value of the word, as computed by the tokenizer
+ * @param length the length of the word
+ * @timeComplexity O(1)
+ */
+void addToSignature(SIGNATURE* sp, unsigned hash, size_t length) {
+    assert(sp != NULL);
+    assert(!sp->finished);
+    uint64_t h = mixHash(hash, length);
+    unsigned bin = (h >> 32) * sp->numBins >> 32;
+    if (h < sp->bins[bin])
+        sp->bins[bin] = h;
+}
+
+/**
+ * Fills every empty bin with the value of a filled bin chosen by hashing the empty bin's number, as in Shrivastava's
+ * optimal densification. Each empty bin tries the same sequence of bins in every signature, so two files with the
+ * same words still get equal bins, and unlike borrowing from the next filled bin, neighboring empty bins borrow from
+ * unrelated places, which keeps the estimate unbiased when most bins are empty.
+ * A signature with no words at all is left empty.
+ *
+ * @param sp the signature to finish
+ * @timeComplexity O(bins) average case, if at least a constant fraction of the bins are filled
+ */
+void finishSignature(SIGNATURE* sp) {
+    assert(sp != NULL);
+    int n = sp->numBins;
+    sp->finished = true;
+    uint64_t* filled = malloc(n * sizeof(uint64_t));
+    assert(filled != NULL);
+    int count = 0;
+    int i = 0;
+    for (; i < n; i++) {
+        filled[i] = sp->bins[i];
+        count += sp->bins[i] != EMPTY_BIN;
+    }
+    if (count > 0 && count < n) {
+        for (i = 0; i < n; i++) {
+            unsigned attempt = 0;
+            while (sp->bins[i] == EMPTY_BIN)
+                sp->bins[i] = filled[(mixHash(i, ++attempt) >> 32) * n >> 32];
+        }
+    }
+    free(filled);
+}
+
+/**
+ * Returns an estimate of the Jaccard similarity of the vocabularies of two signatures,
+ * the number of words in both divided by the number of words in either.
+ * Two signatures with no words are considered identical.
+ *
+ * @param sp1 the first finished signature
+ * @param sp2 the second finished signature, which must have the same number of bins
+ * @return the estimated similarity, from 0 to 1
+ * @timeComplexity O(bins)
+ */
+double estimateJaccard(SIGNATURE* sp1, SIGNATURE* sp2) {
+    assert(sp1 != NULL && sp2 != NULL);
+    assert(sp1->finished && sp2->finished);
+    assert(sp1->numBins == sp2->numBins);
+    int equal = 0;
+    int i = 0;
+    for (; i < sp1->numBins; i++)
+        equal += sp1->bins[i] == sp2->bins[i];
+    return (double) equal / sp1->numBins;
+}
+
+/**
+ * Returns a hash of one band of the signature, for locality sensitive hashing.
+ * Signatures that agree on every bin of a band get the same band hash, so files likely to be near duplicates
+ * can be found by grouping equal band hashes instead of comparing every pair.
+ *
+ * @param sp the finished signature
+ * @param band which band, from 0
+ * @param rows the number of bins in each band
+ * @return the hash of bins band * rows to band * rows + rows - 1
+ * @timeComplexity O(rows)
+ */
+uint64_t bandHash(SIGNATURE* sp, int band, int rows) {
+    assert(sp != NULL);
+    assert(sp->finished);
+    assert(rows > 0 && band >= 0 && (band + 1) * rows <= sp->numBins);
+    uint64_t hash = band;
+    int i = band * rows;
+    for (; i < (band + 1) * rows; i++)
+        hash = (hash ^ sp->bins[i]) * 0x100000001b3ULL;
+    return hash;
+}
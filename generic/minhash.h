@@ -0,0 +1,31 @@
+/*
+ * File:        minhash.h
+ *
+ * Description: This file contains the public function and type
+ *              declarations for one-permutation MinHash signatures.  A
+ *              signature summarizes the vocabulary of a file in a fixed
+ *              number of 64-bit values, and the Jaccard similarity of two
+ *              vocabularies is estimated by comparing their signatures.
+ */
+
+# ifndef MINHASH_H
+# define MINHASH_H
+
+# include <stddef.h>
+# include <stdint.h>
+
+typedef struct signature SIGNATURE;
+
+SIGNATURE *createSignature(int bins);
+
+void destroySignature(SIGNATURE *sp);
+
+void addToSignature(SIGNATURE *sp, unsigned hash, size_t length);
+
+void finishSignature(SIGNATURE *sp);
+
+double estimateJaccard(SIGNATURE *sp1, SIGNATURE *sp2);
+
+uint64_t bandHash(SIGNATURE *sp, int band, int rows);
+
+# endif /* MINHASH_H */
@@ -9,13 +9,27 @@
  *              The program takes a single file as a command line argument.
  *              A set is used to maintain a collection of words that occur
  *              an odd number of times.  The counts of total words and
- *              words appearing an odd number of times are printed.
+ *              words appearing an odd number of times are printed.  The
+ *              file may be a corpus file written by encode, in which case
+ *              the parity is kept in a bitset indexed by word number, and
+ *              the -t option splits the corpus among several threads.
+ *              A text file is split at whitespace, at newlines with the
+ *              --lines option, or at the given characters with --delim,
+ *              and the --normalize option folds case and strips punctuation.
+ *              The --utf8 option treats the text as UTF-8.
  */
 
 # include <stdio.h>
 # include <stdlib.h>
 # include <string.h>
+# include <stdbool.h>
+# include <assert.h>
+# include <pthread.h>
 # include "set.h"
+# include "estimate.h"
+# include "corpus.h"
+# include "bitset.h"
+# include "tokenizer.h"
 
 
 /* This is sufficient for the test cases in /scratch/coen12. */
@@ -41,6 +55,125 @@ static unsigned strhash(char *s)
 }
 
 
+/* One piece of a corpus whose parity is computed by a separate thread. */
+
+struct part {
+    char *path;
+    int index, count;
+    BITSET *parity;
+    int words;
+    bool corrupt, threaded;
+};
+
+
+/*
+ * Function:	partParity
+ *
+ * Description:	Thread function that opens its own handle on the corpus,
+ *		reads one part of its token stream, and flips the bit of
+ *		each word in its own bitset.
+ */
+
+static void *partParity(void *arg)
+{
+    struct part *pp = arg;
+    CORPUS *cp;
+    FILE *fp;
+    uint32_t id;
+
+
+    fp = fopen(pp->path, "r");
+    assert(fp != NULL);
+    cp = openCorpus(fp);
+    assert(cp != NULL);
+    seekCorpusPart(cp, pp->index, pp->count);
+
+    while (nextCorpusToken(cp, &id)) {
+	pp->words ++;
+	flipBit(pp->parity, id);
+    }
+
+    pp->corrupt = corpusError(cp);
+    destroyCorpus(cp);
+    fclose(fp);
+    return NULL;
+}
+
+
+/*
+ * Function:	corpusParity
+ *
+ * Description:	Return the number of words in the corpus CP that occur an
+ *		odd number of times, and add the number of tokens to WORDS.
+ *		With more than one thread, each thread reads a part of the
+ *		corpus named PATH into its own bitset and the bitsets are
+ *		combined with exclusive or.  Return -1 if the corpus is
+ *		truncated or corrupt, or its parts do not add up to the
+ *		number of tokens in its header.
+ */
+
+static int corpusParity(CORPUS *cp, char *path, int threads, int *words)
+{
+    struct part *parts;
+    pthread_t *tids;
+    BITSET *parity;
+    uint32_t id;
+    int i, odd, total;
+    bool corrupt;
+
+
+    parity = createBitset(numCorpusWords(cp));
+
+    if (threads == 1) {
+	while (nextCorpusToken(cp, &id)) {
+	    (*words) ++;
+	    flipBit(parity, id);
+	}
+
+	corrupt = corpusError(cp);
+
+    } else {
+	corrupt = corpusError(cp);
+	total = 0;
+	parts = malloc(threads * sizeof(struct part));
+	tids = malloc(threads * sizeof(pthread_t));
+	assert(parts != NULL && tids != NULL);
+
+	for (i = 0; i < threads; i ++) {
+	    parts[i].path = path;
+	    parts[i].index = i;
+	    parts[i].count = threads;
+	    parts[i].parity = createBitset(numCorpusWords(cp));
+	    parts[i].words = 0;
+	    parts[i].corrupt = false;
+	    parts[i].threaded = pthread_create(&tids[i], NULL, partParity, &parts[i]) == 0;
+	}
+
+	for (i = 0; i < threads; i ++) {
+	    if (parts[i].threaded)
+		pthread_join(tids[i], NULL);
+	    else
+		partParity(&parts[i]); /* no thread could be created for it */
+
+	    xorBitset(parity, parts[i].parity);
+	    destroyBitset(parts[i].parity);
+	    total += parts[i].words;
+	    corrupt = corrupt || parts[i].corrupt;
+	}
+
+	*words += total;
+	corrupt = corrupt || total != numCorpusTokens(cp);
+
+	free(tids);
+	free(parts);
+    }
+
+    odd = corrupt ? -1 : countBits(parity);
+    destroyBitset(parity);
+    return odd;
+}
+
+
 /*
  * Function:    main
  *
@@ -50,15 +183,46 @@ static unsigned strhash(char *s)
 int main(int argc, char *argv[])
 {
     FILE *fp;
-    char buffer[BUFSIZ], *word;
+    char *word, *delimiters = NULL;
+    TOKENIZER *tp;
+    struct token tok;
     SET *odd;
-    int words;
+    CORPUS *corpus;
+    int i, words, odds, size, threads = 1;
+    bool sflag = false, lines = false, normalize = false, utf8 = false;
 
 
     /* Check usage and open the file. */
 
+    while (argc > 1 && argv[1][0] == '-') {
+	if (strcmp(argv[1], "--lines") == 0)
+	    lines = true;
+	else if (strcmp(argv[1], "--normalize") == 0)
+	    normalize = true;
+	else if (strcmp(argv[1], "--utf8") == 0)
+	    utf8 = true;
+	else if (strncmp(argv[1], "--delim=", 8) == 0 && argv[1][8] != '\0')
+	    delimiters = argv[1] + 8;
+	else if (strcmp(argv[1], "-s") == 0)
+	    sflag = true;
+	else if (strcmp(argv[1], "-t") != 0)
+	    break;
+	else if (argc > 2 && (threads = atoi(argv[2])) > 0) {
+	    argc --;
+
+	    for (i = 1; i < argc; i ++)
+		argv[i] = argv[i + 1];
+	} else
+	    argc = 0;
+
+	argc --;
+
+	for (i = 1; i < argc; i ++)
+	    argv[i] = argv[i + 1];
+    }
+
     if (argc != 2) {
-        fprintf(stderr, "usage: %s file1\n", argv[0]);
+        fprintf(stderr, "usage: %s [-s] [-t threads] [--lines | --delim=chars] [--normalize] [--utf8] file1\n", argv[0]);
         exit(EXIT_FAILURE);
     }
 
@@ -71,22 +235,50 @@ int main(int argc, char *argv[])
     /* Insert or delete words to compute their parity. */
 
     words = 0;
-    odd = createSet(MAX_SIZE, strcmp, strhash);
 
-    while (fscanf(fp, "%s", buffer) == 1) {
-        words ++;
+    if ((corpus = openCorpus(fp)) != NULL) {
+	odds = corpusParity(corpus, argv[1], threads, &words);
+	destroyCorpus(corpus);
 
-        if ((word = findElement(odd, buffer)) != NULL) {
-            removeElement(odd, buffer);
-	    free(word);
-	} else
-            addElement(odd, strdup(buffer));
+	if (odds < 0) {
+	    fprintf(stderr, "%s: corrupt corpus %s\n", argv[0], argv[1]);
+	    exit(EXIT_FAILURE);
+	}
+
+    } else {
+
+	/* Size the set from a sample of the file if desired. */
+
+	size = sflag ? estimateWords(fp, MAX_SIZE) * 4 / 3 + 1 : MAX_SIZE;
+	odd = createSet(size, strcmp, strhash);
+	setAutoShrink(odd, true);
+	tp = createTokenizer(fp);
+	setTokenizerLines(tp, lines);
+	setTokenizerNormalize(tp, normalize);
+	setTokenizerUtf8(tp, utf8);
+
+	if (delimiters != NULL)
+	    setTokenizerDelimiters(tp, delimiters);
+
+	while (nextToken(tp, &tok)) {
+	    words ++;
+
+	    if ((word = findElement(odd, tok.text)) != NULL) {
+		removeElement(odd, tok.text);
+		free(word);
+	    } else
+		addElement(odd, strdup(tok.text));
+	}
+
+	destroyTokenizer(tp);
+
+	odds = numElements(odd);
+	destroySet(odd);
     }
 
     printf("%d total words\n", words);
-    printf("%d words occur an odd number of times\n", numElements(odd));
+    printf("%d words occur an odd number of times\n", odds);
     fclose(fp);
 
-    destroySet(odd);
     exit(EXIT_SUCCESS);
 }
@@ -0,0 +1,242 @@
+/*
+ * File:        paritybench.c
+ *
+ * Description: This file contains the main function for comparing ways of
+ *              computing word parity over a corpus file written by encode.
+ *
+ *              The program takes a corpus file and an optional number of
+ *              threads as command line arguments.  The parity of every
+ *              word is computed by toggling words in a hash table, by
+ *              flipping bits in a bitset, and by flipping bits in one
+ *              bitset per thread, and the rate of each in tokens per
+ *              second is printed.
+ */
+
+# include <stdio.h>
+# include <stdlib.h>
+# include <string.h>
+# include <stdint.h>
+# include <assert.h>
+# include <pthread.h>
+# include <time.h>
+# include "set.h"
+# include "corpus.h"
+# include "bitset.h"
+
+
+/* One piece of the corpus read by a separate thread. */
+
+struct part {
+    char *path;
+    int index, count;
+    BITSET *parity;
+};
+
+
+/*
+ * Function:    seconds
+ *
+ * Description: Return the current time in seconds.
+ */
+
+static double seconds(void)
+{
+    struct timespec ts;
+
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+/*
+ * Function:    strhash
+ *
+ * Description: Return a hash value for a string S.
+ */
+
+static unsigned strhash(char *s)
+{
+    unsigned hash = 0;
+
+
+    while (*s != '\0')
+        hash = 31 * hash + *s ++;
+
+    return hash;
+}
+
+
+/*
+ * Function:    openPart
+ *
+ * Description: Open the corpus named PATH, restricted to part INDEX of
+ *              COUNT parts.
+ */
+
+static CORPUS *openPart(char *path, int index, int count, FILE **fpp)
+{
+    CORPUS *cp;
+
+
+    *fpp = fopen(path, "r");
+    assert(*fpp != NULL);
+    cp = openCorpus(*fpp);
+    assert(cp != NULL);
+    seekCorpusPart(cp, index, count);
+    return cp;
+}
+
+
+/*
+ * Function:    partParity
+ *
+ * Description: Thread function that flips the bit of each word in its
+ *              part of the corpus.
+ */
+
+static void *partParity(void *arg)
+{
+    struct part *pp = arg;
+    CORPUS *cp;
+    FILE *fp;
+    uint32_t id;
+
+
+    cp = openPart(pp->path, pp->index, pp->count, &fp);
+
+    while (nextCorpusToken(cp, &id))
+	flipBit(pp->parity, id);
+
+    destroyCorpus(cp);
+    fclose(fp);
+    return NULL;
+}
+
+
+/*
+ * Function:    report
+ *
+ * Description: Print the rate of one method.
+ */
+
+static void report(char *name, long long tokens, double elapsed, int odd)
+{
+    printf("%-16s %8.3f s %8.1f M tokens/s (%d odd)\n",
+	name, elapsed, tokens / elapsed / 1e6, odd);
+}
+
+
+/*
+ * Function:    main
+ *
+ * Description: Driver function for the benchmark.
+ */
+
+int main(int argc, char *argv[])
+{
+    struct part *parts;
+    pthread_t *tids;
+    CORPUS *cp;
+    FILE *fp;
+    SET *odd;
+    BITSET *parity;
+    uint32_t id;
+    char *word, name[32];
+    long long tokens;
+    double start;
+    int i, threads, words;
+
+
+    threads = argc > 2 ? atoi(argv[2]) : 4;
+
+    if (argc < 2 || argc > 3 || threads <= 0) {
+        fprintf(stderr, "usage: %s corpusfile [threads]\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    if ((fp = fopen(argv[1], "r")) == NULL || (cp = openCorpus(fp)) == NULL || corpusError(cp)) {
+        fprintf(stderr, "%s: cannot read corpus %s\n", argv[0], argv[1]);
+        exit(EXIT_FAILURE);
+    }
+
+    tokens = numCorpusTokens(cp);
+    words = numCorpusWords(cp);
+    destroyCorpus(cp);
+    fclose(fp);
+
+
+    /* Toggle the words in a hash table, as the text path of parity does. */
+
+    cp = openPart(argv[1], 0, 1, &fp);
+    odd = createSet(words, strcmp, strhash);
+
+    start = seconds();
+
+    while (nextCorpusToken(cp, &id)) {
+	word = corpusWord(cp, id);
+
+	if (findElement(odd, word) != NULL)
+	    removeElement(odd, word);
+	else
+	    addElement(odd, word);
+    }
+
+    report("hash toggle", tokens, seconds() - start, numElements(odd));
+    destroySet(odd);
+    destroyCorpus(cp);
+    fclose(fp);
+
+
+    /* Flip bits in a single bitset. */
+
+    cp = openPart(argv[1], 0, 1, &fp);
+    parity = createBitset(words);
+
+    start = seconds();
+
+    while (nextCorpusToken(cp, &id))
+	flipBit(parity, id);
+
+    report("bitset", tokens, seconds() - start, countBits(parity));
+    destroyBitset(parity);
+    destroyCorpus(cp);
+    fclose(fp);
+
+
+    /* Flip bits in one bitset per thread and combine them. */
+
+    parts = malloc(threads * sizeof(struct part));
+    tids = malloc(threads * sizeof(pthread_t));
+    assert(parts != NULL && tids != NULL);
+
+    parity = NULL;
+    start = seconds();
+
+    for (i = 0; i < threads; i ++) {
+	parts[i].path = argv[1];
+	parts[i].index = i;
+	parts[i].count = threads;
+	parts[i].parity = createBitset(words);
+	pthread_create(&tids[i], NULL, partParity, &parts[i]);
+    }
+
+    for (i = 0; i < threads; i ++) {
+	pthread_join(tids[i], NULL);
+
+	if (parity == NULL)
+	    parity = parts[i].parity;
+	else {
+	    xorBitset(parity, parts[i].parity);
+	    destroyBitset(parts[i].parity);
+	}
+    }
+
+    sprintf(name, "bitset x%d", threads);
+    report(name, tokens, seconds() - start, countBits(parity));
+
+    destroyBitset(parity);
+    free(tids);
+    free(parts);
+    exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,267 @@
+//partition.c
+/**
+ * This file (partition.c) is an implementation for radix partitioning words by hash value.
+ * Each partition is a list of chunks holding records one after another: the hash value and length of a word,
+ * then the word itself, null terminated and padded so the next record is aligned.
+ * Records are first gathered in a small staging buffer per partition and copied to the partition's chunk a buffer at a time.
+ * With many partitions, writing each record straight to its chunk would touch a different page for nearly every word,
+ * while the staging buffers together fit in the cache and are written out in long sequential copies.
+ *
+ * @author Max Blennemann
+ * @version 10/18/26
+ */
+
+#include "partition.h"
+#include <stdlib.h>
+#include <stdint.h>
+#include <assert.h>
+#include <string.h>
+#define MAX_BITS 16 // Most bits of the hash value partitions are chosen by
+#define STAGE_SIZE 256 // Size in bytes of the staging buffer of a partition, a few cache lines
+#define MIN_CHUNK (16 << 10) // Size in bytes of the first chunk of a partition
+#define MAX_CHUNK (1 << 20) // Size in bytes chunks stop growing at
+#define ALIGNMENT 4 // Alignment of every record
+
+typedef struct record {
+    uint32_t hash; // Hash value of the word
+    uint32_t length; // Length of the word, which follows the record
+} record;
+
+typedef struct chunk {
+    struct chunk* next; // The chunk allocated before this one
+    size_t used; // Number of bytes of records in the chunk
+    size_t size; // Number of bytes of data in the chunk
+    _Alignas(ALIGNMENT) unsigned char data[];
+} chunk;
+
+typedef struct partition {
+    _Alignas(64) unsigned char stage[STAGE_SIZE]; // Records not yet copied to a chunk
+    size_t staged; // Number of bytes in stage
+    chunk* chunks; // Chunks holding the records, newest first
+    unsigned long words; // Number of words in the partition
+} partition;
+
+typedef struct partitions {
+    partition* parts; // The partitions
+    int bits; // Number of bits of the hash value partitions are chosen by
+} partitionSet;
+
+/**
+ * Returns the number of bytes a record for a word of the given length takes up, including padding.
+ *
+ * @param length the length of the word
+ * @return the size of the record
+ * @timeComplexity O(1)
+ */
+static size_t recordSize(size_t length) {
+    return (sizeof(record) + length + 1 + ALIGNMENT - 1) & ~(size_t) (ALIGNMENT - 1);
+}
+
+/**
+ * Returns new, empty partitions for 2^bits partitions.
+ *
+ * @param bits the number of high bits of the hash value that choose a word's partition
+ * @return the newly allocated partitions
+ * @timeComplexity O(2^bits)
+ */
+PARTITIONS* createPartitions(int bits) {
+    assert(bits >= 0 && bits <= MAX_BITS);
+    partitionSet* a = malloc(sizeof(partitionSet));
+    assert(a != NULL);
+    a->bits = bits;
+    a->parts = aligned_alloc(64, ((size_t) 1 << bits) * sizeof(partition));
+    assert(a->parts != NULL);
+    int i = 0;
+    for (; i < 1 << bits; i++) {
+        a->parts[i].staged = 0;
+        a->parts[i].chunks = NULL;
+        a->parts[i].words = 0;
+    }
+    return a;
+}
+
+/**
+ * Frees the partitions and every word in them.
+ *
+ * @param pp the partitions to destroy
+ * @timeComplexity O(P + C) Where P is the number of partitions and C is the number of chunks
+ */
+void destroyPartitions(PARTITIONS* pp) {
+    assert(pp != NULL);
+    int i = 0;
+    for (; i < 1 << pp->bits; i++) {
+        chunk* c = pp->parts[i].chunks;
+        while (c != NULL) {
+            chunk* next = c->next;
+            free(c);
+            c = next;
+        }
+    }
+    free(pp->parts);
+    free(pp);
+}
+
+/**
+ * Returns the number of partitions.
+ *
+ * @param pp the partitions to access
+ * @return the number of partitions, 2^bits
+ * @timeComplexity O(1)
+ */
+int numPartitions(PARTITIONS* pp) {
+    assert(pp != NULL);
+    return 1 << pp->bits;
+}
+
+/**
+ * Returns space for the given number of bytes of records at the end of a partition's newest chunk,
+ * starting a new chunk, twice as big as the last up to MAX_CHUNK, if there is not enough room.
+ *
+ * @param p the partition to add to
+ * @param n the number of bytes needed
+ * @return the space, which the caller fills in
+ * @timeComplexity O(1)
+ */
+static unsigned char* reserveBytes(partition* p, size_t n) {
+    chunk* c = p->chunks;
+    if (c == NULL || c->used + n > c->size) {
+        size_t size = c == NULL ? MIN_CHUNK : c->size < MAX_CHUNK ? 2 * c->size : MAX_CHUNK;
+        if (size < n)
+            size = n;
+        chunk* fresh = malloc(sizeof(chunk) + size);
+        assert(fresh != NULL);
+        fresh->next = c;
+        fresh->used = 0;
+        fresh->size = size;
+        p->chunks = c = fresh;
+    }
+    unsigned char* space = c->data + c->used;
+    c->used += n;
+    return space;
+}
+
+/**
+ * Copies the staging buffer of a partition to its newest chunk and empties it.
+ *
+ * @param p the partition to flush
+ * @timeComplexity O(STAGE_SIZE)
+ */
+static void flushStage(partition* p) {
+    if (p->staged > 0) {
+        memcpy(reserveBytes(p, p->staged), p->stage, p->staged);
+        p->staged = 0;
+    }
+}
+
+/**
+ * Writes the record for a word at the given place.
+ *
+ * @param dest where the record goes
+ * @param word the characters of the word, which do not need to be null terminated
+ * @param length the length of the word
+ * @param hash the hash value of the word
+ * @timeComplexity O(length)
+ */
+static void writeRecord(unsigned char* dest, const char* word, size_t length, unsigned hash) {
+    record r = {hash, length};
+    memcpy(dest, &r, sizeof(record));
+    memcpy(dest + sizeof(record), word, length);
+    dest[sizeof(record) + length] = '\0';
+}
+
+/**
+ * Copies a word and its hash value into the partition chosen by the high bits of the hash value.
+ * The hash value is mixed first so the partitions are evenly used even by short words, whose hash values are small.
+ *
+ * @param pp the partitions to add to
+ * @param word the characters of the word, which do not need to be null terminated
+ * @param length the length of the word
+ * @param hash the hash value of the word
+ * @timeComplexity O(length) amortized
+ */
+void scatterWord(PARTITIONS* pp, const char* word, size_t length, unsigned hash) {
+    assert(pp != NULL);
+    assert(word != NULL);
+    partition* p = &pp->parts[pp->bits > 0 ? (uint32_t) (hash * 0x9e3779b1u) >> (32 - pp->bits) : 0];
+    size_t n = recordSize(length);
+    p->words++;
+    if (p->staged + n > STAGE_SIZE) {
+        flushStage(p);
+        if (n > STAGE_SIZE) {
+            writeRecord(reserveBytes(p, n), word, length, hash);
+            return;
+        }
+    }
+    writeRecord(p->stage + p->staged, word, length, hash);
+    p->staged += n;
+}
+
+/**
+ * Copies every staging buffer to its partition's chunks, which must be done before the words are visited.
+ *
+ * @param pp the partitions to flush
+ * @timeComplexity O(P) Where P is the number of partitions
+ */
+void flushPartitions(PARTITIONS* pp) {
+    assert(pp != NULL);
+    int i = 0;
+    for (; i < 1 << pp->bits; i++)
+        flushStage(&pp->parts[i]);
+}
+
+/**
+ * Returns the number of words copied into a partition, counting every copy of a word.
+ *
+ * @param pp the partitions to access
+ * @param part the index of the partition
+ * @return the number of words
+ * @timeComplexity O(1)
+ */
+unsigned long partitionWords(PARTITIONS* pp, int part) {
+    assert(pp != NULL);
+    assert(part >= 0 && part < 1 << pp->bits);
+    return pp->parts[part].words;
+}
+
+/**
+ * Calls visit(word, arg) for every word copied into a partition, where word is the null terminated copy.
+ * The copies stay valid until the partitions are destroyed, so they can be kept as keys.
+ * Different partitions may be visited by different threads at the same time.
+ *
+ * @param pp the flushed partitions to access
+ * @param part the index of the partition
+ * @param visit the function to call for each word
+ * @param arg passed through to visit
+ * @timeComplexity O(N) Where N is the number of bytes of words in the partition
+ */
+void forEachWord(PARTITIONS* pp, int part, void (* visit)(), void* arg) {
+    assert(pp != NULL);
+    assert(part >= 0 && part < 1 << pp->bits);
+    assert(visit != NULL);
+    assert(pp->parts[part].staged == 0);
+    chunk* c = pp->parts[part].chunks;
+    for (; c != NULL; c = c->next) {
+        size_t offset = 0;
+        while (offset < c->used) {
+            record r;
+            memcpy(&r, c->data + offset, sizeof(record));
+            (*visit)((char*) c->data + offset + sizeof(record), arg);
+            offset += recordSize(r.length);
+        }
+    }
+}
+
+/**
+ * Returns the hash value stored with a word visited by forEachWord, without hashing it again.
+ * This can be given as the hash function of a set or map keyed by the copies.
+ *
+ * @param word a copy visited by forEachWord
+ * @return the hash value given to scatterWord
+ * @timeComplexity O(1)
+ */
+unsigned partitionedHash(char* word) {
+    assert(word != NULL);
+    record r;
+    memcpy(&r, word - sizeof(record), sizeof(record));
+    return r.hash;
+}
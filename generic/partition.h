@@ -0,0 +1,36 @@
+/*
+ * File:        partition.h
+ *
+ * Description: This file contains the public function and type
+ *              declarations for radix partitioning words by hash value.
+ *              Each word is copied, with its hash value, into one of 2^k
+ *              partitions chosen by the high bits of the hash, so every
+ *              copy of a word lands in the same partition and each one
+ *              can later be counted on its own with a table small enough
+ *              to stay in the cache.
+ */
+
+# ifndef PARTITION_H
+# define PARTITION_H
+
+# include <stddef.h>
+
+typedef struct partitions PARTITIONS;
+
+PARTITIONS *createPartitions(int bits);
+
+void destroyPartitions(PARTITIONS *pp);
+
+int numPartitions(PARTITIONS *pp);
+
+void scatterWord(PARTITIONS *pp, const char *word, size_t length, unsigned hash);
+
+void flushPartitions(PARTITIONS *pp);
+
+unsigned long partitionWords(PARTITIONS *pp, int part);
+
+void forEachWord(PARTITIONS *pp, int part, void (*visit)(), void *arg);
+
+unsigned partitionedHash(char *word);
+
+# endif /* PARTITION_H */
@@ -0,0 +1,160 @@
+//pool.c
+/**
+ * This file (pool.c) is an implementation for the pool allocator.
+ * Fixed-size records are carved out of large slabs, and strings are copied one after another into arena chunks.
+ * Allocating is a pointer bump, and destroying the pool frees one block per slab or chunk instead of one per record.
+ * A freed record is kept on a free list and reused by the next allocObject.
+ *
+ * @author Max Blennemann
+ * @version 10/18/26
+ */
+
+#include "pool.h"
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#define SLAB_SIZE 65536 // Size in bytes of a slab or string chunk
+#define ALIGNMENT 16 // Alignment of every record
+
+typedef struct block {
+    struct block* next; // The block allocated before this one
+    size_t used; // Number of bytes of data handed out
+    size_t size; // Number of bytes of data in the block
+    _Alignas(ALIGNMENT) char data[];
+} block;
+
+typedef struct pool {
+    size_t objectSize; // Size in bytes of a record, rounded up to ALIGNMENT
+    block* slabs; // Slabs records are allocated from, newest first
+    block* chunks; // Chunks strings are copied into, newest first
+    void* freeList; // Records given back by freeObject, linked through their first bytes
+} genericPool;
+
+/**
+ * Allocates a new block with room for at least size bytes of data and puts it at the front of a list.
+ *
+ * @param list the list to add the block to
+ * @param size the smallest number of bytes of data the block must hold
+ * @return the new block
+ * @timeComplexity O(1)
+ */
+static block* addBlock(block** list, size_t size) {
+    if (size < SLAB_SIZE - sizeof(block))
+        size = SLAB_SIZE - sizeof(block);
+    block* b = malloc(sizeof(block) + size);
+    assert(b != NULL);
+    b->next = *list;
+    b->used = 0;
+    b->size = size;
+    *list = b;
+    return b;
+}
+
+/**
+ * Frees every block in a list.
+ *
+ * @param list the first block of the list
+ * @timeComplexity O(N) Where N is the number of blocks
+ */
+static void freeBlocks(block* list) {
+    while (list != NULL) {
+        block* next = list->next;
+        free(list);
+        list = next;
+    }
+}
+
+/**
+ * Returns a new pool for records of the given size.
+ * A pool used only for strings may be created with an objectSize of 0.
+ *
+ * @param objectSize the size in bytes of the records allocObject returns
+ * @return the newly allocated pool
+ * @timeComplexity O(1)
+ */
+POOL* createPool(size_t objectSize) {
+    genericPool* a = malloc(sizeof(genericPool));
+    assert(a != NULL);
+    if (objectSize < sizeof(void*))
+        objectSize = sizeof(void*); // room for the free list link
+    a->objectSize = (objectSize + ALIGNMENT - 1) & ~(size_t) (ALIGNMENT - 1);
+    a->slabs = NULL;
+    a->chunks = NULL;
+    a->freeList = NULL;
+    return a;
+}
+
+/**
+ * Frees the pool and every record and string allocated from it.
+ *
+ * @param pp the pool to destroy
+ * @timeComplexity O(N) Where N is the number of slabs and chunks
+ */
+void destroyPool(POOL* pp) {
+    assert(pp != NULL);
+    freeBlocks(pp->slabs);
+    freeBlocks(pp->chunks);
+    free(pp);
+}
+
+/**
+ * Returns a new record of the size given to createPool.
+ * The contents of the record are not initialized.
+ *
+ * @param pp the pool to allocate from
+ * @return the new record
+ * @timeComplexity O(1)
+ */
+void* allocObject(POOL* pp) {
+    assert(pp != NULL);
+    if (pp->freeList != NULL) {
+        void* obj = pp->freeList;
+        pp->freeList = *(void**) obj;
+        return obj;
+    }
+    block* b = pp->slabs;
+    if (b == NULL || b->used + pp->objectSize > b->size)
+        b = addBlock(&pp->slabs, pp->objectSize);
+    void* obj = b->data + b->used;
+    b->used += pp->objectSize;
+    return obj;
+}
+
+/**
+ * Gives a record back to the pool so a later allocObject can reuse it.
+ * The memory itself is only freed when the pool is destroyed.
+ *
+ * @param pp the pool the record was allocated from
+ * @param obj the record to give back
+ * @timeComplexity O(1)
+ */
+void freeObject(POOL* pp, void* obj) {
+    assert(pp != NULL);
+    if (obj != NULL) {
+        *(void**) obj = pp->freeList;
+        pp->freeList = obj;
+    }
+}
+
+/**
+ * Copies length characters of a string into the arena and null terminates the copy.
+ * The characters being copied do not need to be null terminated, so a word can be copied straight out of a buffer.
+ *
+ * @param pp the pool to allocate from
+ * @param s the characters to copy
+ * @param length the number of characters to copy
+ * @return the copy, which stays valid until the pool is destroyed
+ * @timeComplexity O(length)
+ */
+char* allocString(POOL* pp, const char* s, size_t length) {
+    assert(pp != NULL);
+    assert(s != NULL);
+    block* b = pp->chunks;
+    if (b == NULL || b->used + length + 1 > b->size)
+        b = addBlock(&pp->chunks, length + 1);
+    char* copy = b->data + b->used;
+    memcpy(copy, s, length);
+    copy[length] = '\0';
+    b->used += length + 1;
+    return copy;
+}
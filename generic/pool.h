@@ -0,0 +1,29 @@
+/*
+ * File:        pool.h
+ *
+ * Description: This file contains the public function and type
+ *              declarations for a pool allocator.  A pool hands out
+ *              fixed-size records from large slabs and copies strings into
+ *              a contiguous arena, so drivers that store records or words
+ *              in a set allocate by bumping a pointer and free everything
+ *              at once when the pool is destroyed.
+ */
+
+# ifndef POOL_H
+# define POOL_H
+
+# include <stddef.h>
+
+typedef struct pool POOL;
+
+POOL *createPool(size_t objectSize);
+
+void destroyPool(POOL *pp);
+
+void *allocObject(POOL *pp);
+
+void freeObject(POOL *pp, void *obj);
+
+char *allocString(POOL *pp, const char *s, size_t length);
+
+# endif /* POOL_H */
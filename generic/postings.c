@@ -0,0 +1,352 @@
+//postings.c
+/**
+ * This file (postings.c) is an implementation for the compressed posting list.
+ * Positions are kept as the differences between consecutive positions, in blocks of 128.
+ * A full block is written as one byte giving the number of bits b of its largest difference,
+ * followed by 4 * b 32-bit little endian words holding the 128 differences packed b bits each.
+ * The differences are packed in four interleaved lanes, with difference i in lane i % 4,
+ * so a block is packed and unpacked four differences at a time with SIMD shifts and masks,
+ * and turned back into positions with a prefix sum of four at a time.
+ * The last, partial, block is written as varints (7 bits per byte, low bits first) when the list is finished.
+ *
+ * @author Max Blennemann
+ * @version 10/18/26
+ */
+
+#include "postings.h"
+#include <stdlib.h>
+#include <assert.h>
+#include <stdbool.h>
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#define BLOCK_SIZE 128 // Number of positions packed together
+#define LANES 4 // Number of differences packed side by side
+#define MIN_BYTES 16 // Smallest size of the array of encoded bytes
+#define MIN_PENDING 4 // Smallest size of the array of positions not yet packed
+
+typedef struct postings {
+    unsigned char* bytes; // The encoded blocks
+    size_t length; // Number of bytes of bytes that hold data
+    size_t capacity; // How much space is allocated to bytes
+    uint32_t* pending; // Positions added since the last full block
+    unsigned int numPending; // Number of positions in pending
+    unsigned int pendingSize; // How much space is allocated to pending
+    uint32_t count; // Number of positions added
+    uint32_t base; // The last position of the last full block, which the next difference is taken from
+    uint32_t last; // The last position added
+    bool finished; // Whether the partial block has been written
+} postingList;
+
+/**
+ * Makes room for the given number of bytes at the end of the encoded bytes.
+ *
+ * @param pp the posting list
+ * @param n the number of bytes to be added
+ * @return the first byte of the room made
+ * @timeComplexity O(N) worst case; O(1) amortized Where N is the number of bytes
+ */
+static unsigned char* reserveBytes(POSTINGS* pp, size_t n) {
+    if (pp->length + n > pp->capacity) {
+        while (pp->length + n > pp->capacity)
+            pp->capacity = pp->capacity > 0 ? pp->capacity * 2 : MIN_BYTES;
+        pp->bytes = realloc(pp->bytes, pp->capacity);
+        assert(pp->bytes != NULL);
+    }
+    unsigned char* p = pp->bytes + pp->length;
+    pp->length += n;
+    return p;
+}
+
+/**
+ * Returns the number of bits needed to hold the given value.
+ *
+ * @param x the value
+ * @return the position of the highest set bit plus one, or 0 if x is 0
+ * @timeComplexity O(1)
+ */
+static inline int bitWidth(uint32_t x) {
+    return x != 0 ? 32 - __builtin_clz(x) : 0;
+}
+
+/**
+ * Packs 128 differences, b bits each, in four interleaved lanes.
+ * Word w of lane l is out[w * 4 + l], so each group of four words is one SIMD register.
+ *
+ * @param deltas the differences, each less than 2 to the b
+ * @param b the number of bits per difference
+ * @param out where the 4 * b packed words are written
+ * @timeComplexity O(1)
+ */
+static void packBlock(const uint32_t* deltas, int b, uint32_t* out) {
+#ifdef __SSE2__
+    __m128i acc = _mm_setzero_si128();
+    int shift = 0;
+    int i = 0;
+    for (; i < BLOCK_SIZE / LANES; i++) {
+        __m128i v = _mm_loadu_si128((const __m128i*) (deltas + i * LANES));
+        acc = _mm_or_si128(acc, _mm_sll_epi32(v, _mm_cvtsi32_si128(shift)));
+        shift += b;
+        if (shift >= 32) {
+            _mm_storeu_si128((__m128i*) out, acc);
+            out += LANES;
+            shift -= 32;
+            acc = shift > 0 ? _mm_srl_epi32(v, _mm_cvtsi32_si128(b - shift)) : _mm_setzero_si128();
+        }
+    }
+#else
+    int lane = 0;
+    for (; lane < LANES; lane++) {
+        uint32_t acc = 0;
+        int shift = 0, w = 0, i = 0;
+        for (; i < BLOCK_SIZE / LANES; i++) {
+            uint32_t v = deltas[i * LANES + lane];
+            acc |= shift < 32 ? v << shift : 0;
+            shift += b;
+            if (shift >= 32) {
+                out[w++ * LANES + lane] = acc;
+                shift -= 32;
+                acc = shift > 0 ? v >> (b - shift) : 0;
+            }
+        }
+    }
+#endif
+}
+
+/**
+ * Unpacks a block packed by packBlock and adds up its differences into positions.
+ *
+ * @param in the 4 * b packed words
+ * @param b the number of bits per difference
+ * @param base the position before the first of the block
+ * @param out where the 128 positions are written
+ * @timeComplexity O(1)
+ */
+static void unpackBlock(const uint32_t* in, int b, uint32_t base, uint32_t* out) {
+#ifdef __SSE2__
+    __m128i mask = _mm_set1_epi32(b < 32 ? (int) ((1u << b) - 1) : -1);
+    __m128i sum = _mm_set1_epi32((int) base);
+    __m128i word = b > 0 ? _mm_loadu_si128((const __m128i*) in) : _mm_setzero_si128();
+    int shift = 0, w = 1;
+    int i = 0;
+    for (; i < BLOCK_SIZE / LANES; i++) {
+        __m128i v = _mm_srl_epi32(word, _mm_cvtsi32_si128(shift));
+        shift += b;
+        if (shift >= 32) {
+            shift -= 32;
+            if (w < b)
+                word = _mm_loadu_si128((const __m128i*) (in + w++ * LANES));
+            if (shift > 0)
+                v = _mm_or_si128(v, _mm_sll_epi32(word, _mm_cvtsi32_si128(b - shift)));
+        }
+        v = _mm_and_si128(v, mask);
+        v = _mm_add_epi32(v, _mm_slli_si128(v, 4));
+        v = _mm_add_epi32(v, _mm_slli_si128(v, 8));
+        v = _mm_add_epi32(v, _mm_shuffle_epi32(sum, 0xFF));
+        _mm_storeu_si128((__m128i*) (out + i * LANES), v);
+        sum = v;
+    }
+#else
+    uint32_t mask = b < 32 ? (1u << b) - 1 : UINT32_MAX;
+    int lane = 0;
+    for (; lane < LANES; lane++) {
+        uint32_t word = b > 0 ? in[lane] : 0;
+        int shift = 0, w = 1, i = 0;
+        for (; i < BLOCK_SIZE / LANES; i++) {
+            uint32_t v = shift < 32 ? word >> shift : 0;
+            shift += b;
+            if (shift >= 32) {
+                shift -= 32;
+                if (w < b)
+                    word = in[w++ * LANES + lane];
+                if (shift > 0)
+                    v |= word << (b - shift);
+            }
+            out[i * LANES + lane] = v & mask;
+        }
+    }
+    int i = 0;
+    for (; i < BLOCK_SIZE; i++)
+        base = out[i] += base;
+#endif
+}
+
+/**
+ * Packs the full block of pending positions onto the end of the encoded bytes.
+ *
+ * @param pp the posting list
+ * @timeComplexity O(1)
+ */
+static void flushBlock(POSTINGS* pp) {
+    uint32_t deltas[BLOCK_SIZE], bits = 0, previous = pp->base;
+    int i = 0;
+    for (; i < BLOCK_SIZE; i++) {
+        deltas[i] = pp->pending[i] - previous;
+        previous = pp->pending[i];
+        bits |= deltas[i];
+    }
+    int b = bitWidth(bits);
+    unsigned char* p = reserveBytes(pp, 1 + b * LANES * sizeof(uint32_t));
+    *p = b;
+    uint32_t packed[32 * LANES];
+    packBlock(deltas, b, packed);
+    memcpy(p + 1, packed, b * LANES * sizeof(uint32_t));
+    pp->base = previous;
+    pp->numPending = 0;
+}
+
+/**
+ * Returns a new, empty posting list.
+ *
+ * @return the newly allocated posting list
+ * @timeComplexity O(1)
+ */
+POSTINGS* createPostings(void) {
+    postingList* a = malloc(sizeof(postingList));
+    assert(a != NULL);
+    a->bytes = NULL;
+    a->length = 0;
+    a->capacity = 0;
+    a->pending = NULL;
+    a->numPending = 0;
+    a->pendingSize = 0;
+    a->count = 0;
+    a->base = 0;
+    a->last = 0;
+    a->finished = false;
+    return a;
+}
+
+/**
+ * Frees the memory allocated to the posting list.
+ *
+ * @param pp the posting list to destroy
+ * @timeComplexity O(1)
+ */
+void destroyPostings(POSTINGS* pp) {
+    assert(pp != NULL);
+    free(pp->bytes);
+    free(pp->pending);
+    free(pp);
+}
+
+/**
+ * Adds a position to the end of the list.
+ * Positions must be added in increasing order, though a position may be repeated.
+ *
+ * @param pp the posting list to add to
+ * @param position the position, at least as large as the last one added
+ * @timeComplexity O(1) amortized
+ */
+void addPosting(POSTINGS* pp, uint32_t position) {
+    assert(pp != NULL && !pp->finished);
+    assert(pp->count == 0 || position >= pp->last);
+    if (pp->numPending == pp->pendingSize) {
+        pp->pendingSize = pp->pendingSize > 0 ? pp->pendingSize * 2 : MIN_PENDING;
+        pp->pending = realloc(pp->pending, pp->pendingSize * sizeof(uint32_t));
+        assert(pp->pending != NULL);
+    }
+    pp->pending[pp->numPending++] = position;
+    pp->count++;
+    pp->last = position;
+    if (pp->numPending == BLOCK_SIZE)
+        flushBlock(pp);
+}
+
+/**
+ * Returns the number of positions in the list.
+ *
+ * @param pp the posting list to access
+ * @return the number of positions added
+ * @timeComplexity O(1)
+ */
+uint32_t numPostings(POSTINGS* pp) {
+    assert(pp != NULL);
+    return pp->count;
+}
+
+/**
+ * Returns the last position added to the list, so a caller can avoid adding the same position twice.
+ *
+ * @param pp the posting list to access, which must not be empty
+ * @return the last position
+ * @timeComplexity O(1)
+ */
+uint32_t lastPosting(POSTINGS* pp) {
+    assert(pp != NULL && pp->count > 0);
+    return pp->last;
+}
+
+/**
+ * Writes the partial block and returns the encoded list, which can then be saved and given to decodePostings.
+ * No more positions can be added afterwards.
+ *
+ * @param pp the posting list to finish
+ * @param length set to the number of encoded bytes
+ * @return the encoded bytes, which stay valid until the list is destroyed
+ * @timeComplexity O(B) Where B is the size of a block
+ */
+const unsigned char* finishPostings(POSTINGS* pp, size_t* length) {
+    assert(pp != NULL && length != NULL);
+    if (!pp->finished) {
+        uint32_t previous = pp->base;
+        unsigned int i = 0;
+        for (; i < pp->numPending; i++) {
+            uint32_t delta = pp->pending[i] - previous;
+            previous = pp->pending[i];
+            do {
+                *reserveBytes(pp, 1) = (delta & 0x7F) | (delta >= 0x80 ? 0x80 : 0);
+                delta >>= 7;
+            } while (delta != 0);
+        }
+        free(pp->pending);
+        pp->pending = NULL;
+        pp->numPending = pp->pendingSize = 0;
+        pp->finished = true;
+    }
+    *length = pp->length;
+    return pp->bytes;
+}
+
+/**
+ * Returns the positions of an encoded posting list.
+ *
+ * @param bytes the encoded list, as returned by finishPostings
+ * @param length the number of encoded bytes
+ * @param count the number of positions in the list
+ * @return a newly allocated array of the positions, which the caller must free, or NULL if the bytes are malformed
+ * @timeComplexity O(n) Where n is count
+ */
+uint32_t* decodePostings(const unsigned char* bytes, size_t length, uint32_t count) {
+    uint32_t* positions = malloc(((size_t) count + 1) * sizeof(uint32_t));
+    assert(positions != NULL);
+    uint32_t base = 0, packed[32 * LANES];
+    size_t pos = 0;
+    uint32_t i = 0;
+    for (; i + BLOCK_SIZE <= count; i += BLOCK_SIZE) {
+        int b = pos < length ? bytes[pos++] : 33;
+        if (b > 32 || pos + b * LANES * sizeof(uint32_t) > length) {
+            free(positions);
+            return NULL;
+        }
+        memcpy(packed, bytes + pos, b * LANES * sizeof(uint32_t));
+        pos += b * LANES * sizeof(uint32_t);
+        unpackBlock(packed, b, base, positions + i);
+        base = positions[i + BLOCK_SIZE - 1];
+    }
+    for (; i < count; i++) {
+        uint32_t delta = 0;
+        int shift = 0;
+        do {
+            if (pos >= length || shift > 28) {
+                free(positions);
+                return NULL;
+            }
+            delta |= (uint32_t) (bytes[pos] & 0x7F) << shift;
+            shift += 7;
+        } while (bytes[pos++] & 0x80);
+        base = positions[i] = base + delta;
+    }
+    return positions;
+}
@@ -0,0 +1,33 @@
+/*
+ * File:        postings.h
+ *
+ * Description: This file contains the public function and type
+ *              declarations for a compressed posting list.  A posting
+ *              list holds the increasing positions at which one word
+ *              appears, such as line numbers or word offsets, stored as
+ *              bit-packed differences between consecutive positions.
+ */
+
+# ifndef POSTINGS_H
+# define POSTINGS_H
+
+# include <stddef.h>
+# include <stdint.h>
+
+typedef struct postings POSTINGS;
+
+POSTINGS *createPostings(void);
+
+void destroyPostings(POSTINGS *pp);
+
+void addPosting(POSTINGS *pp, uint32_t position);
+
+uint32_t numPostings(POSTINGS *pp);
+
+uint32_t lastPosting(POSTINGS *pp);
+
+const unsigned char *finishPostings(POSTINGS *pp, size_t *length);
+
+uint32_t *decodePostings(const unsigned char *bytes, size_t length, uint32_t count);
+
+# endif /* POSTINGS_H */
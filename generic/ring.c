@@ -0,0 +1,326 @@
+//ring.c
+/**
+ * This file (ring.c) is an implementation for counting words over a sliding window.
+ * A totals map holds the count of every word in the window, and a ring of bucket maps holds the counts
+ * added while each bucket was the newest, keyed by the word's copy in the totals map so a bucket compares
+ * pointers instead of strings.
+ * Advancing the ring subtracts the oldest bucket from the totals and reuses it as the newest bucket,
+ * and a word is freed once its count drops to zero, so memory stays bounded by the words in the window.
+ *
+ * @author Max Blennemann
+ * @version 10/18/26
+ */
+
+#include "ring.h"
+#include "map.h"
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <string.h>
+#define MIN_WORDS 16 // Smallest size of a bucket's map
+
+typedef struct ring {
+    MAP* totals; // Maps each word in the window to its struct total
+    MAP** buckets; // Maps the copy of each word to its count in the bucket
+    int numBuckets; // Number of buckets in the ring
+    int newest; // Index of the bucket words are added to
+} slidingRing;
+
+struct total {
+    char* word; // The copy of the word, which is also its key
+    int count; // Number of times the word appears in the window
+};
+
+struct top {
+    char** words; // The words found so far, as a heap with the smallest count first
+    int* counts; // The count of each word in the heap
+    int k; // Largest number of words to keep
+    int n; // Number of words in the heap
+};
+
+/**
+ * Method given in lab documentation.
+ * Returns a hash value for the given string.
+ *
+ * @param s the string to get a hash for
+ * @return the hash value
+ * @timeComplexity O(N)
+ */
+static unsigned strhash(char* s) {
+    unsigned hash = 0;
+    while (*s != '\0')
+        hash = 31 * hash + *s++;
+    return hash;
+}
+
+/**
+ * Returns a hash value for the address of a word's copy.
+ *
+ * @param p the copy of the word
+ * @return the hash value
+ * @timeComplexity O(1)
+ */
+static unsigned ptrhash(char* p) {
+    uintptr_t h = (uintptr_t) p >> 3;
+    h ^= h >> 16;
+    h *= 0x45d9f3b;
+    return (unsigned) (h ^ h >> 16);
+}
+
+/**
+ * Compares the addresses of two words' copies, as every word in a bucket is the copy held by the totals map.
+ *
+ * @param p1 the copy of the first word
+ * @param p2 the copy of the second word
+ * @return 0 if they are the same copy, and nonzero otherwise
+ * @timeComplexity O(1)
+ */
+static int ptrcmp(char* p1, char* p2) {
+    return p1 != p2;
+}
+
+/**
+ * Returns a new ring with the given number of buckets.
+ * The ring grows as needed, so maxWords only needs to be an estimate of the distinct words in the window.
+ *
+ * @param numBuckets the number of buckets the window is split into
+ * @param maxWords the number of distinct words expected in the window
+ * @return the newly allocated ring
+ * @timeComplexity O(B + N) Where B is numBuckets and N is maxWords
+ */
+RING* createRing(int numBuckets, int maxWords) {
+    assert(numBuckets > 0);
+    assert(maxWords >= 0);
+    slidingRing* a = malloc(sizeof(slidingRing));
+    assert(a != NULL);
+    a->totals = createMap(maxWords * 4 / 3 + 1, sizeof(struct total), strcmp, strhash, NULL);
+    a->buckets = malloc(numBuckets * sizeof(MAP*));
+    assert(a->buckets != NULL);
+    int i = 0;
+    for (; i < numBuckets; i++)
+        a->buckets[i] = createMap(MIN_WORDS, sizeof(int), ptrcmp, ptrhash, NULL);
+    a->numBuckets = numBuckets;
+    a->newest = 0;
+    return a;
+}
+
+/**
+ * Frees a copy of a word still in the window.
+ *
+ * @param word the copy of the word
+ * @param tp the total of the word
+ * @param arg unused
+ * @timeComplexity O(1)
+ */
+static void freeWord(char* word, struct total* tp, void* arg) {
+    free(word);
+}
+
+/**
+ * Frees the ring and every word in it.
+ *
+ * @param rp the ring to destroy
+ * @timeComplexity O(B + N) Where B is the number of buckets and N is the number of words in the window
+ */
+void destroyRing(RING* rp) {
+    assert(rp != NULL);
+    forEachEntry(rp->totals, freeWord, NULL);
+    destroyMap(rp->totals);
+    int i = 0;
+    for (; i < rp->numBuckets; i++)
+        destroyMap(rp->buckets[i]);
+    free(rp->buckets);
+    free(rp);
+}
+
+/**
+ * Returns the number of distinct words in the window.
+ *
+ * @param rp the ring to access
+ * @return the number of distinct words
+ * @timeComplexity O(1)
+ */
+int numRingWords(RING* rp) {
+    assert(rp != NULL);
+    return numEntries(rp->totals);
+}
+
+/**
+ * Counts a word in the newest bucket.
+ * The word is copied the first time it enters the window, so it may be a view into a reused buffer.
+ *
+ * @param rp the ring to add to
+ * @param word the word to count
+ * @timeComplexity O(1) average case
+ */
+void addToRing(RING* rp, char* word) {
+    assert(rp != NULL);
+    assert(word != NULL);
+    struct total* tp = getValue(rp->totals, word);
+    if (tp == NULL) {
+        char* copy = strdup(word);
+        assert(copy != NULL);
+        tp = upsertValue(rp->totals, copy, NULL);
+        tp->word = copy;
+    }
+    tp->count++;
+    incrementValue(rp->buckets[rp->newest], tp->word, 1);
+}
+
+/**
+ * Takes the count of a word in the oldest bucket out of the window, and frees the word once none are left.
+ *
+ * @param word the copy of the word
+ * @param count the count of the word in the bucket
+ * @param rp the ring the bucket belongs to
+ * @timeComplexity O(1) average case
+ */
+static void expireWord(char* word, int* count, RING* rp) {
+    struct total* tp = getValue(rp->totals, word);
+    assert(tp != NULL && tp->count >= *count);
+    tp->count -= *count;
+    if (tp->count == 0) {
+        removeKey(rp->totals, word);
+        free(word);
+    }
+}
+
+/**
+ * Moves the window ahead by the given number of buckets.
+ * Each step expires the oldest bucket and makes it the newest, empty bucket,
+ * so after advancing by the number of buckets or more the window is empty.
+ *
+ * @param rp the ring to advance
+ * @param buckets the number of buckets to move ahead by
+ * @timeComplexity O(W) Where W is the number of distinct words in the expired buckets
+ */
+void advanceRing(RING* rp, int buckets) {
+    assert(rp != NULL);
+    assert(buckets >= 0);
+    if (buckets > rp->numBuckets)
+        buckets = rp->numBuckets;
+    while (buckets-- > 0) {
+        rp->newest = (rp->newest + 1) % rp->numBuckets;
+        forEachEntry(rp->buckets[rp->newest], expireWord, rp);
+        clearMap(rp->buckets[rp->newest]);
+    }
+}
+
+/**
+ * Returns the number of times a word appears in the window.
+ *
+ * @param rp the ring to search through
+ * @param word the word to search for
+ * @return the count of the word, or 0 if it is not in the window
+ * @timeComplexity O(1) average case
+ */
+int ringCount(RING* rp, char* word) {
+    assert(rp != NULL);
+    struct total* tp = getValue(rp->totals, word);
+    return tp != NULL ? tp->count : 0;
+}
+
+/**
+ * Returns whether the word at index i of the heap ranks below the word at index j,
+ * by having a smaller count or, for equal counts, by coming later in strcmp() order.
+ *
+ * @param hp the heap to access
+ * @param i the index of the first word
+ * @param j the index of the second word
+ * @return true if the first word ranks below the second
+ * @timeComplexity O(1) for different counts; O(L) for equal counts Where L is the length of the words
+ */
+static bool ranksBelow(struct top* hp, int i, int j) {
+    if (hp->counts[i] != hp->counts[j])
+        return hp->counts[i] < hp->counts[j];
+    return strcmp(hp->words[i], hp->words[j]) > 0;
+}
+
+/**
+ * Swaps two words of the heap along with their counts.
+ *
+ * @param hp the heap to modify
+ * @param i the index of the first word
+ * @param j the index of the second word
+ * @timeComplexity O(1)
+ */
+static void swapTop(struct top* hp, int i, int j) {
+    char* word = hp->words[i];
+    int count = hp->counts[i];
+    hp->words[i] = hp->words[j];
+    hp->counts[i] = hp->counts[j];
+    hp->words[j] = word;
+    hp->counts[j] = count;
+}
+
+/**
+ * Moves the word at index i down the first n words of the heap until neither child ranks below it.
+ *
+ * @param hp the heap to modify
+ * @param i the index of the word to move
+ * @param n the number of words in the heap
+ * @timeComplexity O(log n)
+ */
+static void siftDown(struct top* hp, int i, int n) {
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= n)
+            return;
+        if (child + 1 < n && ranksBelow(hp, child + 1, child))
+            child++;
+        if (!ranksBelow(hp, child, i))
+            return;
+        swapTop(hp, i, child);
+        i = child;
+    }
+}
+
+/**
+ * Offers a word of the window to the heap, which keeps only the k highest ranked words seen.
+ *
+ * @param word the copy of the word
+ * @param tp the total of the word
+ * @param hp the heap to offer the word to
+ * @timeComplexity O(log k)
+ */
+static void offerWord(char* word, struct total* tp, struct top* hp) {
+    if (hp->n < hp->k) {
+        int i = hp->n++;
+        hp->words[i] = word;
+        hp->counts[i] = tp->count;
+        while (i > 0 && ranksBelow(hp, i, (i - 1) / 2)) {
+            swapTop(hp, i, (i - 1) / 2);
+            i = (i - 1) / 2;
+        }
+    } else if (hp->k > 0 && (tp->count > hp->counts[0] || (tp->count == hp->counts[0] && strcmp(word, hp->words[0]) < 0))) {
+        hp->words[0] = word;
+        hp->counts[0] = tp->count;
+        siftDown(hp, 0, hp->n);
+    }
+}
+
+/**
+ * Finds the k most frequent words in the window, most frequent first, with ties in strcmp() order.
+ * The words are the ring's own copies and are only valid until the ring is advanced.
+ *
+ * @param rp the ring to access
+ * @param k the largest number of words to return
+ * @param words an array of at least k entries filled in with the words
+ * @param counts an array of at least k entries filled in with the count of each word
+ * @return the number of words found, which is k unless the window has fewer distinct words
+ * @timeComplexity O(N log k) Where N is the number of distinct words in the window
+ */
+int topRingWords(RING* rp, int k, char** words, int* counts) {
+    assert(rp != NULL);
+    assert(k >= 0);
+    assert(words != NULL && counts != NULL);
+    struct top heap = {words, counts, k, 0};
+    forEachEntry(rp->totals, offerWord, &heap);
+    int n = heap.n;
+    while (n > 1) {
+        swapTop(&heap, 0, --n);
+        siftDown(&heap, 0, n);
+    }
+    return heap.n;
+}
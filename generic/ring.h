@@ -0,0 +1,32 @@
+/*
+ * File:        ring.h
+ *
+ * Description: This file contains the public function and type
+ *              declarations for counting words over a sliding window.
+ *              The window is a ring of buckets, each holding the counts
+ *              of the words added while it was the newest bucket.  When
+ *              the ring advances, the oldest bucket's counts are taken
+ *              out of the window's totals, so a word's count covers only
+ *              the buckets still in the ring.
+ */
+
+# ifndef RING_H
+# define RING_H
+
+typedef struct ring RING;
+
+RING *createRing(int numBuckets, int maxWords);
+
+void destroyRing(RING *rp);
+
+int numRingWords(RING *rp);
+
+void addToRing(RING *rp, char *word);
+
+void advanceRing(RING *rp, int buckets);
+
+int ringCount(RING *rp, char *word);
+
+int topRingWords(RING *rp, int k, char **words, int *counts);
+
+# endif /* RING_H */
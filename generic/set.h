@@ -12,15 +12,27 @@
 # ifndef SET_H
 # define SET_H
 
+# include <stddef.h>
+# include <stdbool.h>
+
 typedef struct set SET;
 
+struct set_allocator {
+    void *(*allocate)(size_t size, void *context);
+    void (*release)(void *ptr, size_t size, void *context);
+    void *context;
+};
+
 SET *createSet(int maxElts, int (*compare)(), unsigned (*hash)());
 
+SET *createSetWithAllocator(int maxElts, int (*compare)(), unsigned (*hash)(),
+	const struct set_allocator *allocator);
+
 void destroySet(SET *sp);
 
 int numElements(SET *sp);
 
-void addElement(SET *sp, void *elt);
+bool addElement(SET *sp, void *elt);
 
 void removeElement(SET *sp, void *elt);
 
@@ -28,4 +40,30 @@ void *findElement(SET *sp, void *elt);
 
 void *getElements(SET *sp);
 
+void reserveSet(SET *sp, int n);
+
+void shrinkSet(SET *sp);
+
+void setAutoShrink(SET *sp, bool enabled);
+
+void setHugePageThreshold(SET *sp, size_t bytes);
+
+void setLookupFunctions(SET *sp, int (*lookupCompare)(), unsigned (*lookupHash)());
+
+void *findElementBy(SET *sp, void *key);
+
+void *findElementByHash(SET *sp, void *key, unsigned hash);
+
+void findElementsByHash(SET *sp, void **keys, unsigned *hashes, int n, void **results);
+
+void setCopyFunction(SET *sp, void *(*copy)());
+
+void setThreads(SET *sp, int threads);
+
+SET *unionSets(SET *sp1, SET *sp2, bool inPlace);
+
+SET *intersectSets(SET *sp1, SET *sp2, bool inPlace);
+
+SET *differenceSets(SET *sp1, SET *sp2, bool inPlace);
+
 # endif /* SET_H */
@@ -0,0 +1,274 @@
+/*
+ * File:        similar.c
+ *
+ * Description: This file contains the main function for estimating how
+ *              similar the vocabularies of several files are.
+ *
+ *              The program takes two or more files as command line
+ *              arguments.  Each file is read once and summarized by a
+ *              MinHash signature, and the estimated Jaccard similarity of
+ *              every pair of files is printed.  With the -b option the
+ *              signatures are split into bands and only pairs that agree
+ *              on a whole band are printed, which finds near duplicates
+ *              without comparing every pair.  With the -x option the
+ *              exact similarity is computed from a set of the words of
+ *              each file and printed as well, for checking the estimates
+ *              on small inputs.
+ */
+
+# include <stdio.h>
+# include <stdlib.h>
+# include <string.h>
+# include <stdbool.h>
+# include <stdint.h>
+# include <assert.h>
+# include "tokenizer.h"
+# include "minhash.h"
+# include "bitset.h"
+# include "set.h"
+# include "pool.h"
+
+
+# define DEFAULT_BINS 128
+# define MAX_FILES 65535
+
+
+/* The band hash of one file, for grouping files by band. */
+
+struct bandkey {
+    uint64_t hash;
+    int file;
+};
+
+
+/* The words of every exact set, which are freed all at once at the end. */
+
+static POOL *pool;
+
+
+/*
+ * Function:    strhash
+ *
+ * Description: Return a hash value for a string S.
+ */
+
+static unsigned strhash(char *s)
+{
+    unsigned hash = 0;
+
+
+    while (*s != '\0')
+        hash = 31 * hash + *s ++;
+
+    return hash;
+}
+
+
+/*
+ * Function:	compareBandKeys
+ *
+ * Description:	Compare two band keys for qsort, by hash and then by file.
+ */
+
+static int compareBandKeys(const void *p1, const void *p2)
+{
+    const struct bandkey *k1 = p1, *k2 = p2;
+
+
+    if (k1->hash != k2->hash)
+	return k1->hash < k2->hash ? -1 : 1;
+
+    return k1->file - k2->file;
+}
+
+
+/*
+ * Function:	readFile
+ *
+ * Description:	Read the file named PATH in one pass, adding every word to
+ *		the signature SIG and, if WORDS is not null, to the set
+ *		WORDS.
+ */
+
+static bool readFile(char *path, SIGNATURE *sig, SET *words)
+{
+    TOKENIZER *tp;
+    struct token tok;
+    FILE *fp;
+
+
+    if ((fp = fopen(path, "r")) == NULL)
+	return false;
+
+    tp = createTokenizer(fp);
+
+    while (nextToken(tp, &tok)) {
+	addToSignature(sig, tok.hash, tok.length);
+
+	if (words != NULL && findElementByHash(words, tok.text, tok.hash) == NULL)
+	    addElement(words, allocString(pool, tok.text, tok.length));
+    }
+
+    destroyTokenizer(tp);
+    fclose(fp);
+    finishSignature(sig);
+    return true;
+}
+
+
+/*
+ * Function:	printPair
+ *
+ * Description:	Print the estimated similarity of files I and J, and the
+ *		exact similarity if their sets of words were kept.
+ */
+
+static void printPair(char **paths, SIGNATURE **sigs, SET **words, int i, int j)
+{
+    SET *common;
+    int both, either;
+
+
+    printf("%s %s %.4f", paths[i], paths[j], estimateJaccard(sigs[i], sigs[j]));
+
+    if (words != NULL) {
+	common = intersectSets(words[i], words[j], false);
+	both = numElements(common);
+	either = numElements(words[i]) + numElements(words[j]) - both;
+	printf(" %.4f", either > 0 ? (double) both / either : 1.0);
+	destroySet(common);
+    }
+
+    printf("\n");
+}
+
+
+/*
+ * Function:    main
+ *
+ * Description: Driver function for the similarity application.
+ */
+
+int main(int argc, char *argv[])
+{
+    SIGNATURE **sigs;
+    SET **words = NULL;
+    BITSET *seen;
+    struct bandkey *keys;
+    int i, j, k, m, n, band, bins = DEFAULT_BINS, bands = 0;
+    bool xflag = false;
+
+
+    /* Check usage. */
+
+    while (argc > 2 && argv[1][0] == '-' && strchr("kbx", argv[1][1]) && argv[1][2] == '\0') {
+	if (argv[1][1] == 'x')
+	    xflag = true;
+	else {
+	    if (argv[1][1] == 'k')
+		bins = atoi(argv[2]);
+	    else
+		bands = atoi(argv[2]);
+
+	    argc --;
+
+	    for (i = 1; i < argc; i ++)
+		argv[i] = argv[i + 1];
+	}
+
+	argc --;
+
+	for (i = 1; i < argc; i ++)
+	    argv[i] = argv[i + 1];
+    }
+
+    n = argc - 1;
+
+    if (n < 2 || n > MAX_FILES || bins <= 0 || bands < 0 || bands > bins || argv[1][0] == '-') {
+        fprintf(stderr, "usage: %s [-k bins] [-b bands] [-x] file1 file2 ...\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+
+    /* Read each file once to compute its signature. */
+
+    sigs = malloc(n * sizeof(SIGNATURE *));
+    assert(sigs != NULL);
+
+    if (xflag) {
+	pool = createPool(0);
+	words = malloc(n * sizeof(SET *));
+	assert(words != NULL);
+    }
+
+    for (i = 0; i < n; i ++) {
+	sigs[i] = createSignature(bins);
+
+	if (xflag) {
+	    words[i] = createSet(1024, strcmp, strhash);
+	    setLookupFunctions(words[i], strcmp, strhash);
+	}
+
+	if (!readFile(argv[i + 1], sigs[i], xflag ? words[i] : NULL)) {
+	    fprintf(stderr, "%s: cannot open %s\n", argv[0], argv[i + 1]);
+	    exit(EXIT_FAILURE);
+	}
+    }
+
+
+    /* Compare every pair, or only the pairs that share a band. */
+
+    if (bands == 0) {
+	for (i = 0; i < n; i ++)
+	    for (j = i + 1; j < n; j ++)
+		printPair(argv + 1, sigs, words, i, j);
+
+    } else {
+	seen = createBitset((uint32_t) n * n);
+	keys = malloc(n * sizeof(struct bandkey));
+	assert(keys != NULL);
+
+	for (band = 0; band < bands; band ++) {
+	    for (i = 0; i < n; i ++) {
+		keys[i].hash = bandHash(sigs[i], band, bins / bands);
+		keys[i].file = i;
+	    }
+
+	    qsort(keys, n, sizeof(struct bandkey), compareBandKeys);
+
+	    for (i = 0; i < n; i = k) {
+		for (k = i + 1; k < n && keys[k].hash == keys[i].hash; k ++)
+		    ;
+
+		for (j = i; j < k; j ++)
+		    for (m = j + 1; m < k; m ++)
+			if (!testBit(seen, (uint32_t) keys[j].file * n + keys[m].file))
+			    flipBit(seen, (uint32_t) keys[j].file * n + keys[m].file);
+	    }
+	}
+
+	for (i = 0; i < n; i ++)
+	    for (j = i + 1; j < n; j ++)
+		if (testBit(seen, (uint32_t) i * n + j))
+		    printPair(argv + 1, sigs, words, i, j);
+
+	free(keys);
+	destroyBitset(seen);
+    }
+
+    for (i = 0; i < n; i ++) {
+	destroySignature(sigs[i]);
+
+	if (xflag)
+	    destroySet(words[i]);
+    }
+
+    free(sigs);
+
+    if (xflag) {
+	free(words);
+	destroyPool(pool);
+    }
+
+    exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,589 @@
+//spill.c
+/**
+ * This file (spill.c) is an implementation for counting words within a memory budget.
+ * Words are counted in a map whose keys are copied into a pool, and the bytes of each new word, the map slots
+ * it takes up and the entry it is sorted in are charged against the budget.
+ * When the budget is used up the words are sorted and written to a temporary file as a run, and the map and pool are emptied.
+ * At the end the runs are merged through a heap of their current words, adding up the counts of equal words.
+ * So that only a few run files are open at once, whenever FAN_IN runs have been through the same number of merges
+ * they are merged into one run, and the runs are never allowed to number more than MAX_RUNS.
+ * Runs are written and read through large buffers, so the files are only ever accessed sequentially in big blocks.
+ * If the words fit in the budget nothing is written and the words are sorted in memory.
+ *
+ * @author Max Blennemann
+ * @version 10/18/26
+ */
+
+#include "spill.h"
+#include "map.h"
+#include "pool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <assert.h>
+#include <string.h>
+#define MIN_WORDS 1024 // Initial size of the map
+#define SLOT_BYTES 48 // Bytes of map slots charged to each word, as the map is up to 3/8 full after growing
+#define WRITE_BUFFER (1 << 20) // Size of the buffer runs are written through
+#define MIN_READ_BUFFER (64 << 10) // Smallest buffer a run is read through while merging
+#define MAX_READ_BUFFER (1 << 20) // Largest buffer a run is read through while merging
+#define FAN_IN 8 // Number of runs of the same level that are merged into one
+#define MAX_RUNS 32 // Most runs kept open at once, above which they are all merged into one
+
+struct entry {
+    uint64_t prefix; // The first 8 bytes of the word as a big-endian number, zero padded
+    char* word; // The copy of the word in the pool
+    long count; // Number of times the word was counted
+};
+
+struct run {
+    FILE* fp; // The temporary file holding the run
+    unsigned char* buffer; // Bytes read from the file but not yet used
+    size_t start; // Index of the first unused byte in buffer
+    size_t end; // Number of bytes in buffer
+    size_t size; // How much space is allocated to buffer
+    char* word; // The word of the current record
+    size_t capacity; // How much space is allocated to word
+    long count; // The count of the current record
+    int level; // Number of merges the words of the run have been through
+};
+
+typedef struct spill {
+    size_t budget; // Bytes the map and pool may use before they are spilled
+    size_t used; // Bytes charged against the budget so far
+    MAP* counts; // Maps each word counted since the last spill to its count
+    POOL* words; // Holds the copy of every word in counts
+    unsigned char* output; // Buffer a run is written through
+    size_t written; // Number of bytes in output
+    bool failed; // Whether creating or writing a run failed
+    struct run* runs; // The runs written so far
+    int numRuns; // Number of runs open, each of which may hold several runs merged together
+    int runsWritten; // Number of runs spilled from memory
+    int maxRuns; // How much space is allocated to runs
+    int* heap; // Indices of the runs that have a current record, smallest word first
+    int heapSize; // Number of runs in heap
+    struct entry* sorted; // The words in strcmp() order when nothing was spilled
+    unsigned numSorted; // Number of words in sorted
+    unsigned next; // Index in sorted of the next word to return
+    char* last; // The word last returned from the runs
+    size_t lastCapacity; // How much space is allocated to last
+    bool finished; // Whether finishSpill has been called
+} wordSpill;
+
+/**
+ * Method given in lab documentation.
+ * Returns a hash value for the given string.
+ *
+ * @param s the string to get a hash for
+ * @return the hash value
+ * @timeComplexity O(N)
+ */
+static unsigned strhash(char* s) {
+    unsigned hash = 0;
+    while (*s != '\0')
+        hash = 31 * hash + *s++;
+    return hash;
+}
+
+/**
+ * Returns a new spill that counts words in memory until they take up about the given number of bytes.
+ *
+ * @param budget the bytes the words and their counts may take up in memory
+ * @return the newly allocated spill
+ * @timeComplexity O(1)
+ */
+SPILL* createSpill(size_t budget) {
+    assert(budget > 0);
+    wordSpill* a = malloc(sizeof(wordSpill));
+    assert(a != NULL);
+    a->budget = budget;
+    a->used = 0;
+    a->counts = createMap(MIN_WORDS, sizeof(long), strcmp, strhash, NULL);
+    a->words = createPool(0);
+    a->output = NULL;
+    a->written = 0;
+    a->failed = false;
+    a->runs = NULL;
+    a->numRuns = 0;
+    a->runsWritten = 0;
+    a->maxRuns = 0;
+    a->heap = NULL;
+    a->heapSize = 0;
+    a->sorted = NULL;
+    a->numSorted = 0;
+    a->next = 0;
+    a->last = NULL;
+    a->lastCapacity = 0;
+    a->finished = false;
+    return a;
+}
+
+/**
+ * Frees the spill, closing and so deleting its run files.
+ *
+ * @param sp the spill to destroy
+ * @timeComplexity O(R) Where R is the number of runs
+ */
+void destroySpill(SPILL* sp) {
+    assert(sp != NULL);
+    int i = 0;
+    for (; i < sp->numRuns; i++) {
+        fclose(sp->runs[i].fp);
+        free(sp->runs[i].buffer);
+        free(sp->runs[i].word);
+    }
+    if (sp->counts != NULL)
+        destroyMap(sp->counts);
+    if (sp->words != NULL)
+        destroyPool(sp->words);
+    free(sp->output);
+    free(sp->runs);
+    free(sp->heap);
+    free(sp->sorted);
+    free(sp->last);
+    free(sp);
+}
+
+/**
+ * Returns the number of runs spilled from memory so far, which is 0 while every word has fit in the budget.
+ * Fewer files than this may be open, as runs are merged together along the way.
+ *
+ * @param sp the spill to access
+ * @return the number of runs
+ * @timeComplexity O(1)
+ */
+int numRuns(SPILL* sp) {
+    assert(sp != NULL);
+    return sp->runsWritten;
+}
+
+/**
+ * Appends one word and its count to the array of entries being collected.
+ *
+ * @param word the word
+ * @param count the count of the word
+ * @param next points to the next free entry of the array
+ * @timeComplexity O(1)
+ */
+static void collectEntry(char* word, long* count, struct entry** next) {
+    uint64_t prefix = 0;
+    int i = 0;
+    for (; i < 8 && word[i] != '\0'; i++)
+        prefix |= (uint64_t) (unsigned char) word[i] << (56 - 8 * i);
+    (*next)->prefix = prefix;
+    (*next)->word = word;
+    (*next)->count = *count;
+    (*next)++;
+}
+
+/**
+ * Compares two entries by their words, for qsort().
+ * The prefixes order the words as strcmp() does, so the words themselves, which are scattered
+ * through the pool, are only read when their first 8 bytes are equal.
+ *
+ * @param p1 the first entry
+ * @param p2 the second entry
+ * @return less than, equal to, or greater than 0 as strcmp() on their words
+ * @timeComplexity O(1) for different prefixes; O(L) otherwise Where L is the length of the words
+ */
+static int compareEntries(const void* p1, const void* p2) {
+    const struct entry* e1 = p1;
+    const struct entry* e2 = p2;
+    if (e1->prefix != e2->prefix)
+        return e1->prefix < e2->prefix ? -1 : 1;
+    return strcmp(e1->word, e2->word);
+}
+
+/**
+ * Returns a new array of the words in the map and their counts, sorted by word.
+ *
+ * @param sp the spill to access
+ * @return the sorted entries, numEntries(sp->counts) of them
+ * @timeComplexity O(N log N) Where N is the number of words in the map
+ */
+static struct entry* sortEntries(SPILL* sp) {
+    struct entry* entries = malloc((numEntries(sp->counts) + 1) * sizeof(struct entry));
+    assert(entries != NULL);
+    struct entry* next = entries;
+    forEachEntry(sp->counts, collectEntry, &next);
+    qsort(entries, numEntries(sp->counts), sizeof(struct entry), compareEntries);
+    return entries;
+}
+
+/**
+ * Copies bytes into the output buffer, writing the buffer to a run file whenever it fills up.
+ *
+ * @param sp the spill being written
+ * @param fp the run file
+ * @param data the bytes to copy
+ * @param n the number of bytes
+ * @timeComplexity O(n)
+ */
+static void writeBytes(SPILL* sp, FILE* fp, const void* data, size_t n) {
+    const unsigned char* p = data;
+    while (n > 0) {
+        if (sp->written == WRITE_BUFFER) {
+            if (fwrite(sp->output, 1, sp->written, fp) != sp->written)
+                sp->failed = true;
+            sp->written = 0;
+        }
+        size_t k = WRITE_BUFFER - sp->written < n ? WRITE_BUFFER - sp->written : n;
+        memcpy(sp->output + sp->written, p, k);
+        sp->written += k;
+        p += k;
+        n -= k;
+    }
+}
+
+/**
+ * Writes one record to a run file: the length of the word, the word, and its count.
+ *
+ * @param sp the spill being written
+ * @param fp the run file
+ * @param word the word
+ * @param count the count of the word
+ * @timeComplexity O(L) Where L is the length of the word
+ */
+static void writeRecord(SPILL* sp, FILE* fp, char* word, long count) {
+    uint32_t length = strlen(word);
+    int64_t total = count;
+    writeBytes(sp, fp, &length, sizeof(length));
+    writeBytes(sp, fp, word, length);
+    writeBytes(sp, fp, &total, sizeof(total));
+}
+
+/**
+ * Writes out what is left in the output buffer and makes sure it reached the run file.
+ *
+ * @param sp the spill being written
+ * @param fp the run file
+ * @timeComplexity O(1)
+ */
+static void flushRun(SPILL* sp, FILE* fp) {
+    if (fwrite(sp->output, 1, sp->written, fp) != sp->written || fflush(fp) != 0)
+        sp->failed = true;
+    sp->written = 0;
+}
+
+/**
+ * Puts a run file at the given place in the array of runs, growing the array if it is the end.
+ *
+ * @param sp the spill to add the run to
+ * @param i where to put the run, at most the number of runs
+ * @param fp the run file, already written
+ * @param level the number of merges its words have been through
+ * @timeComplexity O(1) amortized
+ */
+static void placeRun(SPILL* sp, int i, FILE* fp, int level) {
+    if (i == sp->maxRuns) {
+        sp->maxRuns = sp->maxRuns > 0 ? 2 * sp->maxRuns : 16;
+        sp->runs = realloc(sp->runs, sp->maxRuns * sizeof(struct run));
+        assert(sp->runs != NULL);
+    }
+    struct run* rp = &sp->runs[i];
+    rp->fp = fp;
+    rp->buffer = NULL;
+    rp->start = rp->end = rp->size = 0;
+    rp->word = NULL;
+    rp->capacity = 0;
+    rp->level = level;
+    sp->numRuns = i + 1;
+}
+
+/**
+ * Copies the next bytes of a run into the given memory, reading more of the file when its buffer runs out.
+ *
+ * @param rp the run to read
+ * @param data where to copy the bytes
+ * @param n the number of bytes
+ * @return true if all n bytes were read, or false at the end of the run
+ * @timeComplexity O(n)
+ */
+static bool readBytes(struct run* rp, void* data, size_t n) {
+    unsigned char* p = data;
+    while (n > 0) {
+        if (rp->start == rp->end) {
+            rp->start = 0;
+            rp->end = fread(rp->buffer, 1, rp->size, rp->fp);
+            if (rp->end == 0)
+                return false;
+        }
+        size_t k = rp->end - rp->start < n ? rp->end - rp->start : n;
+        memcpy(p, rp->buffer + rp->start, k);
+        rp->start += k;
+        p += k;
+        n -= k;
+    }
+    return true;
+}
+
+/**
+ * Reads the next record of a run into its current word and count.
+ *
+ * @param rp the run to read
+ * @return true if a record was read, or false at the end of the run
+ * @timeComplexity O(L) Where L is the length of the word
+ */
+static bool readRecord(struct run* rp) {
+    uint32_t length;
+    int64_t count;
+    if (!readBytes(rp, &length, sizeof(length)))
+        return false;
+    if (length + 1 > rp->capacity) {
+        rp->capacity = 2 * (length + 1);
+        rp->word = realloc(rp->word, rp->capacity);
+        assert(rp->word != NULL);
+    }
+    bool ok = readBytes(rp, rp->word, length) && readBytes(rp, &count, sizeof(count));
+    assert(ok); // a run is only ever cut short by a bug or a failed write, which finishSpill reports
+    rp->word[length] = '\0';
+    rp->count = count;
+    return true;
+}
+
+/**
+ * Moves the run at the given position of the heap down until neither child has a smaller word.
+ *
+ * @param sp the spill whose heap to fix
+ * @param i the position of the run in the heap
+ * @timeComplexity O(L log R) Where L is the length of the words and R is the number of runs
+ */
+static void siftDown(SPILL* sp, int i) {
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= sp->heapSize)
+            return;
+        if (child + 1 < sp->heapSize && strcmp(sp->runs[sp->heap[child + 1]].word, sp->runs[sp->heap[child]].word) < 0)
+            child++;
+        if (strcmp(sp->runs[sp->heap[child]].word, sp->runs[sp->heap[i]].word) >= 0)
+            return;
+        int run = sp->heap[i];
+        sp->heap[i] = sp->heap[child];
+        sp->heap[child] = run;
+        i = child;
+    }
+}
+
+/**
+ * Moves the run with the smallest word on to its next record, dropping it from the heap at its end.
+ *
+ * @param sp the spill whose heap to advance
+ * @timeComplexity O(L log R) Where L is the length of the words and R is the number of runs
+ */
+static void advanceHeap(SPILL* sp) {
+    if (!readRecord(&sp->runs[sp->heap[0]]))
+        sp->heap[0] = sp->heap[--sp->heapSize];
+    siftDown(sp, 0);
+}
+
+/**
+ * Rewinds the runs from the given one to the last and builds a heap of their first records for merging,
+ * with the budget shared out between their read buffers.
+ *
+ * @param sp the spill whose runs to merge
+ * @param first the index of the first run to merge
+ * @timeComplexity O(R) Where R is the number of runs merged
+ */
+static void startMerge(SPILL* sp, int first) {
+    size_t size = sp->budget / (sp->numRuns - first);
+    size = size < MIN_READ_BUFFER ? MIN_READ_BUFFER : size > MAX_READ_BUFFER ? MAX_READ_BUFFER : size;
+    sp->heap = malloc((sp->numRuns - first) * sizeof(int));
+    assert(sp->heap != NULL);
+    sp->heapSize = 0;
+    int i = first;
+    for (; i < sp->numRuns; i++) {
+        struct run* rp = &sp->runs[i];
+        rp->buffer = malloc(size);
+        assert(rp->buffer != NULL);
+        rp->size = size;
+        if (fseek(rp->fp, 0, SEEK_SET) != 0)
+            sp->failed = true;
+        else if (readRecord(rp))
+            sp->heap[sp->heapSize++] = i;
+    }
+    for (i = sp->heapSize / 2 - 1; i >= 0; i--)
+        siftDown(sp, i);
+}
+
+/**
+ * Returns the next distinct word of the runs being merged and its total count, in strcmp() order.
+ * The word is only valid until the next call.
+ *
+ * @param sp the spill whose runs are being merged
+ * @param word set to the next word
+ * @param count set to the total count of the word
+ * @return true if a word was returned, or false after the last word
+ * @timeComplexity O(K L log R) Where K is the number of runs holding the word, L is the length of the words
+ * and R is the number of runs
+ */
+static bool nextMerged(SPILL* sp, char** word, long* count) {
+    if (sp->heapSize == 0)
+        return false;
+    struct run* rp = &sp->runs[sp->heap[0]];
+    size_t length = strlen(rp->word);
+    if (length + 1 > sp->lastCapacity) {
+        sp->lastCapacity = 2 * (length + 1);
+        sp->last = realloc(sp->last, sp->lastCapacity);
+        assert(sp->last != NULL);
+    }
+    memcpy(sp->last, rp->word, length + 1);
+    *count = 0;
+    while (sp->heapSize > 0 && strcmp(sp->runs[sp->heap[0]].word, sp->last) == 0) {
+        *count += sp->runs[sp->heap[0]].count;
+        advanceHeap(sp);
+    }
+    *word = sp->last;
+    return true;
+}
+
+/**
+ * Merges the runs from the given one to the last into one run in its place, adding up the counts of equal words.
+ * Its level is one more than the highest level merged.
+ *
+ * @param sp the spill whose runs to merge
+ * @param first the index of the first run to merge
+ * @timeComplexity O(W L log R) Where W is the number of records merged, L is the length of the words
+ * and R is the number of runs merged
+ */
+static void mergeRuns(SPILL* sp, int first) {
+    FILE* fp = tmpfile();
+    if (fp == NULL) {
+        sp->failed = true;
+        return;
+    }
+    int level = sp->runs[first].level + 1; // levels never increase along the array
+    startMerge(sp, first);
+    char* word;
+    long count;
+    while (!sp->failed && nextMerged(sp, &word, &count))
+        writeRecord(sp, fp, word, count);
+    flushRun(sp, fp);
+    int i = first;
+    for (; i < sp->numRuns; i++) {
+        fclose(sp->runs[i].fp);
+        free(sp->runs[i].buffer);
+        free(sp->runs[i].word);
+    }
+    free(sp->heap);
+    sp->heap = NULL;
+    sp->heapSize = 0;
+    placeRun(sp, first, fp, level);
+}
+
+/**
+ * Sorts the words in memory and writes them to a new run file, then empties the map and the pool.
+ * Each record of a run is the length of the word, the word, and its count.
+ * Runs are then merged while the last FAN_IN runs have the same level, and all of them if there are MAX_RUNS,
+ * so the number of open files grows only with the logarithm of the number of runs written.
+ * Once a run has failed to be written the words are dropped, since finishSpill reports them incomplete anyway.
+ *
+ * @param sp the spill to write
+ * @timeComplexity O(N log N) Where N is the number of words in the map, plus the cost of any merges
+ */
+static void spillRun(SPILL* sp) {
+    FILE* fp = sp->failed ? NULL : tmpfile();
+    if (fp == NULL)
+        sp->failed = true;
+    else {
+        if (sp->output == NULL) {
+            sp->output = malloc(WRITE_BUFFER);
+            assert(sp->output != NULL);
+        }
+        struct entry* entries = sortEntries(sp);
+        int n = numEntries(sp->counts);
+        int i = 0;
+        for (; i < n; i++)
+            writeRecord(sp, fp, entries[i].word, entries[i].count);
+        flushRun(sp, fp);
+        free(entries);
+        placeRun(sp, sp->numRuns, fp, 0);
+        sp->runsWritten++;
+    }
+    clearMap(sp->counts);
+    destroyPool(sp->words);
+    sp->words = createPool(0);
+    sp->used = 0;
+    while (!sp->failed && sp->numRuns >= FAN_IN
+           && sp->runs[sp->numRuns - FAN_IN].level == sp->runs[sp->numRuns - 1].level)
+        mergeRuns(sp, sp->numRuns - FAN_IN);
+    if (!sp->failed && sp->numRuns == MAX_RUNS)
+        mergeRuns(sp, 0);
+}
+
+/**
+ * Counts a word, spilling the words in memory to a run first if the budget is used up.
+ * The word is copied the first time it is counted after a spill, so it may be a view into a reused buffer.
+ *
+ * @param sp the spill to add to
+ * @param word the word to count
+ * @param count the amount to add to its count
+ * @timeComplexity O(1) average case, plus O(N log N) when N words are spilled
+ */
+void addToSpill(SPILL* sp, char* word, long count) {
+    assert(sp != NULL && !sp->finished);
+    assert(word != NULL);
+    long* vp = getValue(sp->counts, word);
+    if (vp == NULL) {
+        size_t length = strlen(word);
+        size_t bytes = length + 1 + SLOT_BYTES + sizeof(struct entry);
+        if (sp->used + bytes > sp->budget && numEntries(sp->counts) > 0)
+            spillRun(sp);
+        vp = upsertValue(sp->counts, allocString(sp->words, word, length), NULL);
+        sp->used += bytes;
+    }
+    *vp += count;
+}
+
+/**
+ * Finishes counting, so the words can be read back with nextSpilled.
+ * If any run was written, the words still in memory are spilled as a last run and the runs are rewound for merging.
+ *
+ * @param sp the spill to finish
+ * @return true if every run was written successfully, or false if the words read back would be incomplete
+ * @timeComplexity O(N log N) Where N is the number of words in memory, plus O(R) Where R is the number of runs
+ */
+bool finishSpill(SPILL* sp) {
+    assert(sp != NULL && !sp->finished);
+    sp->finished = true;
+    if (sp->numRuns == 0 && !sp->failed) {
+        sp->sorted = sortEntries(sp);
+        sp->numSorted = numEntries(sp->counts);
+        return true;
+    }
+    if (numEntries(sp->counts) > 0)
+        spillRun(sp);
+    destroyMap(sp->counts);
+    sp->counts = NULL;
+    destroyPool(sp->words);
+    sp->words = NULL;
+    free(sp->output);
+    sp->output = NULL;
+    if (sp->failed)
+        return false;
+    startMerge(sp, 0);
+    return !sp->failed;
+}
+
+/**
+ * Returns the next distinct word and its total count, in strcmp() order.
+ * The word is only valid until the next call.
+ *
+ * @param sp the finished spill to read from
+ * @param word set to the next word
+ * @param count set to the total count of the word
+ * @return true if a word was returned, or false after the last word
+ * @timeComplexity O(1) if nothing was spilled; O(K L log R) otherwise Where K is the number of runs holding the word,
+ * L is the length of the words and R is the number of runs
+ */
+bool nextSpilled(SPILL* sp, char** word, long* count) {
+    assert(sp != NULL && sp->finished);
+    assert(word != NULL && count != NULL);
+    if (sp->numRuns == 0) {
+        if (sp->next == sp->numSorted)
+            return false;
+        *word = sp->sorted[sp->next].word;
+        *count = sp->sorted[sp->next++].count;
+        return true;
+    }
+    return nextMerged(sp, word, count);
+}
@@ -0,0 +1,33 @@
+/*
+ * File:        spill.h
+ *
+ * Description: This file contains the public function and type
+ *              declarations for counting words within a memory budget.
+ *              Words are counted in memory until the budget is used up,
+ *              then the counts are sorted and written to a temporary run
+ *              file and counting starts over.  At the end the runs are
+ *              merged, so every distinct word comes back once, in strcmp()
+ *              order, with its total count.
+ */
+
+# ifndef SPILL_H
+# define SPILL_H
+
+# include <stddef.h>
+# include <stdbool.h>
+
+typedef struct spill SPILL;
+
+SPILL *createSpill(size_t budget);
+
+void destroySpill(SPILL *sp);
+
+void addToSpill(SPILL *sp, char *word, long count);
+
+int numRuns(SPILL *sp);
+
+bool finishSpill(SPILL *sp);
+
+bool nextSpilled(SPILL *sp, char **word, long *count);
+
+# endif /* SPILL_H */
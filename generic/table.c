@@ -15,38 +15,204 @@
 #include <assert.h>
 #include <string.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <pthread.h>
 #define EMPTY 'e'
 #define FILLED 'f'
 #define DELETED 'd'
+#define MIN_SIZE 16 // Smallest size the set is resized to
+#define HUGE_PAGE (2UL << 20) // Size of a transparent huge page
+#define HUGE_PAGE_THRESHOLD (64UL << 20) // Default size at which arrays are backed by huge pages
+#define BATCH 16 // Number of elements hashed and prefetched ahead by the set operations
+#define MIN_THREAD_SLOTS 4096 // Fewest slots worth handing to another thread
 
 typedef struct set {
     void** data;
     char* flags; // 'e' = empty, 'f' = filled, 'd' = deleted
     unsigned int count; // Number of elements that contain data
     unsigned int size; // How much space is allocated to the array
+    unsigned int deleted; // Number of elements marked as deleted
+    bool autoShrink; // Whether removeElement shrinks the set when it becomes mostly empty
+    struct set_allocator allocator; // Functions that every table and element allocation goes through
+    size_t hugePageThreshold; // Arrays at least this large are backed by huge pages, or 0 for never
+    bool dataHuge; // Whether data was allocated by hugeAllocate
+    bool flagsHuge; // Whether flags was allocated by hugeAllocate
+    int threads; // Number of threads the set operations may use when this set is the first operand
 
     int (* compare)(); //Method passed in from createSet that compares two elements
 
     unsigned (* hash)(); //Method passed in from createSet that hashes an element
+
+    int (* lookupCompare)(); //Method passed in from setLookupFunctions that compares an element with a lookup key
+
+    unsigned (* lookupHash)(); //Method passed in from setLookupFunctions that hashes a lookup key
+
+    void* (* copy)(); //Method passed in from setCopyFunction that copies a new element, or NULL to store elements as given
 } genericTable;
 
 /**
- * Returns a new set with the specified number of elements as the maximum capacity.
+ * Allocates memory with malloc, for sets created without an allocator.
  *
- * @param maxElts the maximum amount of elements the set can hold
+ * @param size the number of bytes to allocate
+ * @param context unused
+ * @return the allocated memory
+ * @timeComplexity O(1)
+ */
+static void* defaultAllocate(size_t size, void* context) {
+    return malloc(size);
+}
+
+/**
+ * Frees memory allocated by defaultAllocate.
+ *
+ * @param ptr the memory to free
+ * @param size unused
+ * @param context unused
+ * @timeComplexity O(1)
+ */
+static void defaultRelease(void* ptr, size_t size, void* context) {
+    free(ptr);
+}
+
+static const struct set_allocator defaultAllocator = {defaultAllocate, defaultRelease, NULL};
+
+/**
+ * Allocates memory for the set through its allocator.
+ *
+ * @param sp the set the memory is for
+ * @param size the number of bytes to allocate
+ * @return the allocated memory
+ * @timeComplexity O(1) plus the cost of the allocator
+ */
+static void* allocate(SET* sp, size_t size) {
+    void* ptr = (*sp->allocator.allocate)(size, sp->allocator.context);
+    assert(ptr != NULL || size == 0);
+    return ptr;
+}
+
+/**
+ * Gives memory allocated by allocate back to the set's allocator.
+ * Does nothing if the allocator has no release function, as with a region freed all at once.
+ *
+ * @param sp the set the memory is from
+ * @param ptr the memory to release
+ * @param size the number of bytes that were allocated
+ * @timeComplexity O(1) plus the cost of the allocator
+ */
+static void release(SET* sp, void* ptr, size_t size) {
+    if (sp->allocator.release != NULL)
+        (*sp->allocator.release)(ptr, size, sp->allocator.context);
+}
+
+/**
+ * Allocates memory aligned to a huge page and asks the kernel to back it with transparent huge pages.
+ * If the kernel does not support this the memory is still usable with regular pages.
+ * Large tables are probed at random, so with 4 KB pages nearly every probe is also a TLB miss.
+ *
+ * @param size the number of bytes to allocate
+ * @return the allocated memory, or NULL if it could not be mapped
+ * @timeComplexity O(1)
+ */
+static void* hugeAllocate(size_t size) {
+    size_t length = (size + HUGE_PAGE - 1) & ~(HUGE_PAGE - 1);
+    char* p = mmap(NULL, length + HUGE_PAGE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED)
+        return NULL;
+    char* aligned = (char*) (((uintptr_t) p + HUGE_PAGE - 1) & ~(uintptr_t) (HUGE_PAGE - 1));
+    if (aligned > p)
+        munmap(p, aligned - p);
+    if (p + HUGE_PAGE > aligned)
+        munmap(aligned + length, p + HUGE_PAGE - aligned);
+#ifdef MADV_HUGEPAGE
+    madvise(aligned, length, MADV_HUGEPAGE);
+#endif
+    return aligned;
+}
+
+/**
+ * Allocates one of the arrays of the set.
+ * Arrays of at least hugePageThreshold bytes are backed by huge pages when the set uses the default allocator;
+ * a custom allocator is always used as given.
+ *
+ * @param sp the set the array is for
+ * @param size the number of bytes to allocate
+ * @param huge set to whether the array was allocated by hugeAllocate
+ * @return the allocated array
+ * @timeComplexity O(1) plus the cost of the allocator
+ */
+static void* allocateArray(SET* sp, size_t size, bool* huge) {
+    *huge = false;
+    if (sp->hugePageThreshold != 0 && size >= sp->hugePageThreshold && sp->allocator.allocate == defaultAllocate) {
+        void* ptr = hugeAllocate(size);
+        if (ptr != NULL) {
+            *huge = true;
+            return ptr;
+        }
+    }
+    return allocate(sp, size);
+}
+
+/**
+ * Frees an array allocated by allocateArray.
+ *
+ * @param sp the set the array is from
+ * @param ptr the array to free
+ * @param size the number of bytes that were allocated
+ * @param huge whether the array was allocated by hugeAllocate
+ * @timeComplexity O(1) plus the cost of the allocator
+ */
+static void releaseArray(SET* sp, void* ptr, size_t size, bool huge) {
+    if (huge)
+        munmap(ptr, (size + HUGE_PAGE - 1) & ~(HUGE_PAGE - 1));
+    else
+        release(sp, ptr, size);
+}
+
+/**
+ * Returns a new set with the specified number of elements as the initial capacity.
+ * The set grows when it is three quarters full, so maxElts should be about 4/3 of the expected number of elements.
+ *
+ * @param maxElts the initial amount of elements the set can hold
  * @return the newly allocated set
  * @timeComplexity O(N) Where N is the maximum number of elements the set can hold (maxElts)
  */
 SET* createSet(int maxElts, int (* compare)(), unsigned (* hash)()) {
-    genericTable* a = malloc(sizeof(genericTable));
+    return createSetWithAllocator(maxElts, compare, hash, &defaultAllocator);
+}
+
+/**
+ * Returns a new set like createSet, but every allocation the set makes goes through the given allocator.
+ * This includes the set itself and its arrays; the elements are owned by the caller.
+ * The arrays returned by getElements are still allocated with malloc, as the caller frees them.
+ * The allocator is copied, so it does not need to outlive this call, but its context must outlive the set.
+ *
+ * @param maxElts the initial amount of elements the set can hold
+ * @param compare compares two elements as in strcmp()
+ * @param hash returns a hash value for an element
+ * @param allocator the allocate and release functions and the context passed to them
+ * @return the newly allocated set
+ * @timeComplexity O(N) Where N is the maximum number of elements the set can hold (maxElts)
+ */
+SET* createSetWithAllocator(int maxElts, int (* compare)(), unsigned (* hash)(), const struct set_allocator* allocator) {
+    assert(allocator != NULL && allocator->allocate != NULL);
+    genericTable* a = (*allocator->allocate)(sizeof(genericTable), allocator->context);
     assert(a != NULL);
+    a->allocator = *allocator;
     assert(maxElts >= 0);
     a->compare = compare;
     a->hash = hash;
+    a->lookupCompare = NULL;
+    a->lookupHash = NULL;
+    a->copy = NULL;
     a->count = 0;
+    a->deleted = 0;
+    a->autoShrink = false;
     a->size = maxElts;
-    a->data = malloc(maxElts * sizeof(void*));
-    a->flags = malloc(maxElts * sizeof(unsigned));
+    a->hugePageThreshold = HUGE_PAGE_THRESHOLD;
+    a->threads = 1;
+    a->data = allocateArray(a, maxElts * sizeof(void*), &a->dataHuge);
+    a->flags = allocateArray(a, maxElts * sizeof(char), &a->flagsHuge);
     assert(a->data != NULL);
     assert(a->flags != NULL);
     unsigned i = 0;
@@ -63,9 +229,11 @@ SET* createSet(int maxElts, int (* compare)(), unsigned (* hash)()) {
  */
 void destroySet(SET* sp) {
     assert(sp != NULL);
-    free(sp->data);
-    free(sp->flags);
-    free(sp);
+    releaseArray(sp, sp->data, sp->size * sizeof(void*), sp->dataHuge);
+    releaseArray(sp, sp->flags, sp->size * sizeof(char), sp->flagsHuge);
+    struct set_allocator allocator = sp->allocator;
+    if (allocator.release != NULL)
+        (*allocator.release)(sp, sizeof(genericTable), allocator.context);
 }
 
 /**
@@ -81,29 +249,32 @@ int numElements(SET* sp) {
 }
 
 /**
- * Finds the index of an element in the set.
+ * Finds the index of an element in the set given its hash value and a comparison function.
  * Returns the location the element would go if the element is not found.
  * Returns sp->size if the element can't be added.
  * Pass a boolean pointer as found if you want found variable returned as a boolean.
  *
  * @param sp the set to search through
- * @param elt the element to search for
+ * @param key the element, or lookup key, to search for
+ * @param hash the hash value of key, which must equal the hash of the matching element
+ * @param compare compares an element in the set with key as in strcmp()
+ * @param found set to whether the element was found
  * @return the index where the element is or should be added
  * or sp->size if the element is not found
- * @timeComplexity (O(N) + user given hash function) worst case; (O(1) + user given hash function) average case
+ * @timeComplexity (O(N) + user given compare function) worst case; (O(1) + user given compare function) average case
  */
-static unsigned int findElementIndex(SET* sp, void* elt, bool* found) {
+static unsigned int findIndex(SET* sp, void* key, unsigned hash, int (* compare)(), bool* found) {
     assert(sp != NULL);
-    assert(elt != NULL);
-    unsigned const home = (*sp->hash)(elt) % sp->size;
+    assert(key != NULL);
+    unsigned const home = hash % sp->size;
     unsigned index = home;
     unsigned firstDeleted = sp->size;
     if (index < sp->size) {
         if (sp->flags[index] == EMPTY) {
             if (found != NULL)
                 *found = false;
-            return index;
-        } else if (sp->flags[index] == FILLED && (*sp->compare)(sp->data[index], elt) == 0) {
+            return firstDeleted != sp->size ? firstDeleted : index;
+        } else if (sp->flags[index] == FILLED && (*compare)(sp->data[index], key) == 0) {
             if (found != NULL)
                 *found = true;
             return index;
@@ -117,8 +288,8 @@ static unsigned int findElementIndex(SET* sp, void* elt, bool* found) {
         if (sp->flags[index] == EMPTY) {
             if (found != NULL)
                 *found = false;
-            return index;
-        } else if (sp->flags[index] == FILLED && (*sp->compare)(sp->data[index], elt) == 0) {
+            return firstDeleted != sp->size ? firstDeleted : index;
+        } else if (sp->flags[index] == FILLED && (*compare)(sp->data[index], key) == 0) {
             if (found != NULL)
                 *found = true;
             return index;
@@ -133,25 +304,87 @@ static unsigned int findElementIndex(SET* sp, void* elt, bool* found) {
     return firstDeleted;
 }
 
+/**
+ * Finds the index of an element in the set using the hash and compare functions given to createSet.
+ *
+ * @param sp the set to search through
+ * @param elt the element to search for
+ * @param found set to whether the element was found
+ * @return the index where the element is or should be added
+ * or sp->size if the element is not found
+ * @timeComplexity (O(N) + user given hash function) worst case; (O(1) + user given hash function) average case
+ */
+static unsigned int findElementIndex(SET* sp, void* elt, bool* found) {
+    assert(elt != NULL);
+    return findIndex(sp, elt, (*sp->hash)(elt), sp->compare, found);
+}
+
+/**
+ * Moves every element of the set into newly allocated arrays of the given size.
+ * Deleted slots are dropped, so this also clears out deleted markers when newSize equals the current size.
+ *
+ * @param sp the set to resize
+ * @param newSize the new number of slots, which must be larger than the number of elements
+ * @timeComplexity O(N + newSize)
+ */
+static void resizeSet(SET* sp, unsigned newSize) {
+    assert(newSize > sp->count);
+    void** oldData = sp->data;
+    char* oldFlags = sp->flags;
+    unsigned oldSize = sp->size;
+    bool oldDataHuge = sp->dataHuge;
+    bool oldFlagsHuge = sp->flagsHuge;
+    sp->data = allocateArray(sp, newSize * sizeof(void*), &sp->dataHuge);
+    sp->flags = allocateArray(sp, newSize * sizeof(char), &sp->flagsHuge);
+    assert(sp->data != NULL);
+    assert(sp->flags != NULL);
+    memset(sp->flags, EMPTY, newSize);
+    sp->size = newSize;
+    sp->deleted = 0;
+    unsigned i = 0;
+    for (; i < oldSize; i++) {
+        if (oldFlags[i] == FILLED) {
+            unsigned index = (*sp->hash)(oldData[i]) % newSize;
+            while (sp->flags[index] != EMPTY)
+                index = (index + 1) % newSize;
+            sp->data[index] = oldData[i];
+            sp->flags[index] = FILLED;
+        }
+    }
+    releaseArray(sp, oldData, oldSize * sizeof(void*), oldDataHuge);
+    releaseArray(sp, oldFlags, oldSize * sizeof(char), oldFlagsHuge);
+}
+
 /**
  * Adds a new element to the set
- * Sorts the list after the element is added to guarantee the set is sorted
+ * The set stores the pointer it is given, or a copy made by the copy function if one was set; the caller keeps ownership of the element.
+ * Since an element that is already present is not copied, a caller that copies its elements this way can add
+ * straight from a reused buffer and only pays for a copy when the element is new.
  *
  * @param sp the set to add an element to
  * @param elt the element to add.
+ * @return true if the element was added, or false if an equal element was already in the set
  * @timeComplexity (O(N) + user given hash function) worst case; (O(1) + user given hash function) average case
  */
-void addElement(SET* sp, void* elt) {
+bool addElement(SET* sp, void* elt) {
     assert(sp != NULL);
     assert(elt != NULL);
-    assert(sp->count < sp->size);
+    if (4 * (sp->count + sp->deleted + 1) > 3 * sp->size) {
+        if (4 * (sp->count + 1) > 2 * sp->size)
+            resizeSet(sp, sp->size * 2 > MIN_SIZE ? sp->size * 2 : MIN_SIZE);
+        else
+            resizeSet(sp, sp->size); // mostly deleted slots, so just clear them out
+    }
     bool alreadyExists = false;
     unsigned int index = findElementIndex(sp, elt, &alreadyExists);
     if (alreadyExists)
-        return;
-    sp->data[index] = strdup(elt);
+        return false;
+    if (sp->flags[index] == DELETED)
+        sp->deleted--;
+    sp->data[index] = sp->copy != NULL ? (*sp->copy)(elt) : elt;
     sp->flags[index] = FILLED;
     sp->count++;
+    return true;
 }
 
 /**
@@ -172,6 +405,9 @@ void removeElement(SET* sp, void* elt) {
             return;
         sp->flags[index] = DELETED;
         sp->count--;
+        sp->deleted++;
+        if (sp->autoShrink && sp->size > MIN_SIZE && 8 * sp->count < sp->size)
+            resizeSet(sp, 2 * sp->count > MIN_SIZE ? 2 * sp->count : MIN_SIZE);
     }
 }
 
@@ -198,6 +434,171 @@ void* findElement(SET* sp, void* elt) {
     return sp->data[a];
 }
 
+/**
+ * Sets the functions used to look up elements by a key of a different type than the elements.
+ * For example a set of struct entry* records can be searched with a plain char* word,
+ * or with a (pointer, length) view into a buffer, without building a temporary record.
+ * lookupHash(key) must return the same value as the hash given to createSet returns
+ * for the matching element, and lookupCompare(elt, key) must return 0 when they match.
+ *
+ * @param sp the set to modify
+ * @param lookupCompare compares an element in the set with a lookup key as in strcmp()
+ * @param lookupHash returns the hash value of a lookup key, or NULL if callers always pass the hash
+ * @timeComplexity O(1)
+ */
+void setLookupFunctions(SET* sp, int (* lookupCompare)(), unsigned (* lookupHash)()) {
+    assert(sp != NULL);
+    assert(lookupCompare != NULL);
+    sp->lookupCompare = lookupCompare;
+    sp->lookupHash = lookupHash;
+}
+
+/**
+ * Sets the function addElement uses to copy an element the first time it is added.
+ * Elements that are already present are not copied, and the copies are owned by the caller, as the set never frees elements.
+ *
+ * @param sp the set to modify
+ * @param copy returns a copy of an element being added, or NULL to store elements as given
+ * @timeComplexity O(1)
+ */
+void setCopyFunction(SET* sp, void* (* copy)()) {
+    assert(sp != NULL);
+    sp->copy = copy;
+}
+
+/**
+ * Finds the element matching a lookup key, using the functions given to setLookupFunctions.
+ * Returns NULL if no element matches the key.
+ *
+ * @param sp the set to search through
+ * @param key the lookup key to search for
+ * @return a pointer to the matching element otherwise NULL
+ * @timeComplexity O(N) worst case; O(1) average case
+ */
+void* findElementBy(SET* sp, void* key) {
+    assert(sp != NULL);
+    assert(sp->lookupHash != NULL);
+    if (key == NULL)
+        return NULL;
+    return findElementByHash(sp, key, (*sp->lookupHash)(key));
+}
+
+/**
+ * Finds the element matching a lookup key whose hash value the caller has already computed,
+ * for example while tokenizing the input.
+ * Returns NULL if no element matches the key.
+ *
+ * @param sp the set to search through
+ * @param key the lookup key to search for
+ * @param hash the hash value of the key, as the hash given to createSet would return for the matching element
+ * @return a pointer to the matching element otherwise NULL
+ * @timeComplexity O(N) worst case; O(1) average case
+ */
+void* findElementByHash(SET* sp, void* key, unsigned hash) {
+    assert(sp != NULL);
+    assert(sp->lookupCompare != NULL);
+    if (key == NULL)
+        return NULL;
+    bool found = false;
+    unsigned a = findIndex(sp, key, hash, sp->lookupCompare, &found);
+    if (found == false)
+        return NULL;
+    return sp->data[a];
+}
+
+/**
+ * Finds the elements matching many lookup keys whose hash values the caller has already computed.
+ * The keys are handled in batches like the set operations handle elements: the home slots of a whole batch are prefetched
+ * before the first key is compared, so the cache misses of the batch overlap instead of happening one at a time.
+ *
+ * @param sp the set to search through
+ * @param keys the lookup keys to search for
+ * @param hashes the hash value of each key, as for findElementByHash
+ * @param n the number of keys
+ * @param results set to the matching element of each key, or NULL if none matches
+ * @timeComplexity O(n) average case
+ */
+void findElementsByHash(SET* sp, void** keys, unsigned* hashes, int n, void** results) {
+    assert(sp != NULL);
+    assert(sp->lookupCompare != NULL);
+    int i = 0;
+    while (i < n) {
+        int end = n - i > BATCH ? i + BATCH : n;
+        int j = i;
+        if (sp->size > 0)
+            for (; j < end; j++) {
+                __builtin_prefetch(&sp->flags[hashes[j] % sp->size]);
+                __builtin_prefetch(&sp->data[hashes[j] % sp->size]);
+            }
+        for (j = i; j < end; j++) {
+            bool found = false;
+            unsigned index = 0;
+            if (sp->size > 0)
+                index = findIndex(sp, keys[j], hashes[j], sp->lookupCompare, &found);
+            results[j] = found ? sp->data[index] : NULL;
+        }
+        i = end;
+    }
+}
+
+/**
+ * Makes room for at least n elements so a known bulk load does not resize the set repeatedly.
+ * The set is never made smaller by this function.
+ *
+ * @param sp the set to resize
+ * @param n the number of elements the set should hold without growing
+ * @timeComplexity O(N + n)
+ */
+void reserveSet(SET* sp, int n) {
+    assert(sp != NULL);
+    assert(n >= 0);
+    unsigned newSize = (4 * (unsigned) n + 2) / 3;
+    if (newSize > sp->size)
+        resizeSet(sp, newSize);
+}
+
+/**
+ * Shrinks the set so it is about half full, giving the memory of removed elements back.
+ * The set is never made smaller than MIN_SIZE slots or larger than it is.
+ *
+ * @param sp the set to compact
+ * @timeComplexity O(N)
+ */
+void shrinkSet(SET* sp) {
+    assert(sp != NULL);
+    unsigned newSize = 2 * sp->count > MIN_SIZE ? 2 * sp->count : MIN_SIZE;
+    if (newSize < sp->size)
+        resizeSet(sp, newSize);
+}
+
+/**
+ * Turns automatic shrinking on or off.
+ * When on, removeElement shrinks the set to half full once it falls below one eighth full.
+ * Since the set only grows again at three quarters full, alternating adds and removes can not resize it every time.
+ *
+ * @param sp the set to modify
+ * @param enabled whether the set should shrink automatically
+ * @timeComplexity O(1)
+ */
+void setAutoShrink(SET* sp, bool enabled) {
+    assert(sp != NULL);
+    sp->autoShrink = enabled;
+}
+
+/**
+ * Sets the size at which the arrays of the set are backed by transparent huge pages.
+ * The new threshold applies the next time the set is resized, so call this before reserveSet for a bulk load.
+ * Only sets using the default allocator use huge pages.
+ *
+ * @param sp the set to modify
+ * @param bytes the smallest array size in bytes to back with huge pages, or 0 to never use them
+ * @timeComplexity O(1)
+ */
+void setHugePageThreshold(SET* sp, size_t bytes) {
+    assert(sp != NULL);
+    sp->hugePageThreshold = bytes;
+}
+
 /**
  * Copies all the values in the set to a new array and returns that new array.
  * The user must free the array of generics before exiting to avoid a memory leak.
@@ -221,4 +622,302 @@ void* getElements(SET* sp) { //TODO check if this works
         }
     }
     return toReturn;
-}
\ No newline at end of file
+}
+
+/**
+ * Sets the number of threads unionSets, intersectSets and differenceSets may use when this set is their first operand.
+ * The slots of the set being scanned are split into ranges and each thread probes the other set for its range.
+ *
+ * @param sp the set to modify
+ * @param threads the number of threads, at least 1
+ * @timeComplexity O(1)
+ */
+void setThreads(SET* sp, int threads) {
+    assert(sp != NULL);
+    assert(threads >= 1);
+    sp->threads = threads;
+}
+
+struct match {
+    unsigned slot; // Slot of the element in the set being scanned
+    unsigned index; // Where the element is, or would go, in the set being probed
+    unsigned hash; // Hash value of the element
+};
+
+typedef struct probe {
+    SET* source; // The set whose slots are scanned
+    SET* target; // The set each element is looked up in
+    unsigned begin; // First slot of source to scan
+    unsigned end; // One past the last slot of source to scan
+    bool wantFound; // Whether elements found in target are recorded, or elements not found
+    struct match* matches; // The recorded elements, in slot order
+    unsigned count; // Number of recorded elements
+    unsigned capacity; // How much space is allocated to matches
+} probeJob;
+
+/**
+ * Looks up every element in a range of slots of one set in another set, recording the ones the job asks for.
+ * Elements are handled in batches: the hashes of a whole batch are computed and their home slots prefetched
+ * before the first one is compared, so the cache misses of the batch overlap instead of happening one at a time.
+ *
+ * @param job the sets, the range of slots and where to record the results
+ * @timeComplexity (O(R) + user given hash and compare functions) average case Where R is the number of slots in the range
+ */
+static void probeRange(probeJob* job) {
+    SET* source = job->source;
+    SET* target = job->target;
+    unsigned slots[BATCH], hashes[BATCH];
+    unsigned i = job->begin;
+    while (i < job->end) {
+        unsigned n = 0;
+        for (; i < job->end && n < BATCH; i++) {
+            if (source->flags[i] == FILLED) {
+                slots[n] = i;
+                hashes[n] = (*target->hash)(source->data[i]);
+                if (target->size > 0) {
+                    __builtin_prefetch(&target->flags[hashes[n] % target->size]);
+                    __builtin_prefetch(&target->data[hashes[n] % target->size]);
+                }
+                n++;
+            }
+        }
+        unsigned j = 0;
+        for (; j < n; j++) {
+            bool found = false;
+            unsigned index = 0;
+            if (target->size > 0)
+                index = findIndex(target, source->data[slots[j]], hashes[j], target->compare, &found);
+            if (found != job->wantFound)
+                continue;
+            if (job->count == job->capacity) {
+                job->capacity = job->capacity > 0 ? 2 * job->capacity : 64;
+                job->matches = realloc(job->matches, job->capacity * sizeof(struct match));
+                assert(job->matches != NULL);
+            }
+            job->matches[job->count].slot = slots[j];
+            job->matches[job->count].index = index;
+            job->matches[job->count].hash = hashes[j];
+            job->count++;
+        }
+    }
+}
+
+/**
+ * Thread function that runs probeRange.
+ *
+ * @param arg the probeJob to run
+ * @return NULL
+ * @timeComplexity same as probeRange
+ */
+static void* probeThread(void* arg) {
+    probeRange(arg);
+    return NULL;
+}
+
+/**
+ * Looks up every element of source in target, splitting the slots of source among up to the given number of threads.
+ * Neither set is changed, so the threads need no locking; the caller changes the sets afterwards using the results.
+ *
+ * @param source the set whose elements are looked up
+ * @param target the set the elements are looked up in
+ * @param wantFound whether to record the elements found in target, or the elements not found
+ * @param threads the largest number of threads to use
+ * @param count set to the number of recorded elements
+ * @return a new array of the recorded elements, which the caller must free
+ * @timeComplexity (O(N) + user given hash and compare functions) average case Where N is the size of source
+ */
+static struct match* probeSet(SET* source, SET* target, bool wantFound, int threads, unsigned* count) {
+    assert(source->compare == target->compare && source->hash == target->hash);
+    unsigned parts = threads;
+    if (parts > source->size / MIN_THREAD_SLOTS + 1)
+        parts = source->size / MIN_THREAD_SLOTS + 1;
+    probeJob* jobs = malloc(parts * sizeof(probeJob));
+    pthread_t* tids = malloc(parts * sizeof(pthread_t));
+    assert(jobs != NULL && tids != NULL);
+    unsigned i = 0;
+    for (; i < parts; i++) {
+        jobs[i].source = source;
+        jobs[i].target = target;
+        jobs[i].begin = (unsigned long long) source->size * i / parts;
+        jobs[i].end = (unsigned long long) source->size * (i + 1) / parts;
+        jobs[i].wantFound = wantFound;
+        jobs[i].matches = NULL;
+        jobs[i].count = 0;
+        jobs[i].capacity = 0;
+        if (i > 0) {
+            int error = pthread_create(&tids[i], NULL, probeThread, &jobs[i]);
+            assert(error == 0);
+        }
+    }
+    probeRange(&jobs[0]);
+    struct match* matches = jobs[0].matches;
+    *count = jobs[0].count;
+    for (i = 1; i < parts; i++) {
+        pthread_join(tids[i], NULL);
+        if (jobs[i].count > 0) {
+            matches = realloc(matches, (*count + jobs[i].count) * sizeof(struct match));
+            assert(matches != NULL);
+            memcpy(matches + *count, jobs[i].matches, jobs[i].count * sizeof(struct match));
+            *count += jobs[i].count;
+        }
+        free(jobs[i].matches);
+    }
+    free(tids);
+    free(jobs);
+    return matches;
+}
+
+/**
+ * Returns a new empty set with the same functions, allocator and settings as the given set, with room for n elements.
+ *
+ * @param sp the set to copy the settings of
+ * @param n the number of elements the new set will hold
+ * @return the newly allocated set
+ * @timeComplexity O(n)
+ */
+static SET* createSimilarSet(SET* sp, unsigned n) {
+    unsigned size = (4 * n + 2) / 3 + 1;
+    SET* result = createSetWithAllocator(size > MIN_SIZE ? size : MIN_SIZE, sp->compare, sp->hash, &sp->allocator);
+    result->lookupCompare = sp->lookupCompare;
+    result->lookupHash = sp->lookupHash;
+    result->copy = sp->copy;
+    result->autoShrink = sp->autoShrink;
+    result->hugePageThreshold = sp->hugePageThreshold;
+    result->threads = sp->threads;
+    return result;
+}
+
+/**
+ * Adds an element known not to be in the set, without comparing it against anything.
+ * The set must have room for it, so the caller reserves space first.
+ *
+ * @param sp the set to add an element to
+ * @param elt the element to add
+ * @param hash the hash value of the element
+ * @timeComplexity O(1) average case
+ */
+static void insertNew(SET* sp, void* elt, unsigned hash) {
+    assert(sp->count < sp->size);
+    unsigned index = hash % sp->size;
+    while (sp->flags[index] == FILLED)
+        index = (index + 1) % sp->size;
+    if (sp->flags[index] == DELETED)
+        sp->deleted--;
+    sp->data[index] = elt;
+    sp->flags[index] = FILLED;
+    sp->count++;
+}
+
+/**
+ * Removes the element in each of the given slots, then shrinks the set once if it shrinks automatically.
+ *
+ * @param sp the set to remove elements from
+ * @param matches the elements to remove
+ * @param n the number of elements to remove
+ * @param useIndex whether each slot is the index field of the match, or the slot field
+ * @timeComplexity O(n), or O(N) if the set shrinks
+ */
+static void removeSlots(SET* sp, struct match* matches, unsigned n, bool useIndex) {
+    unsigned i = 0;
+    for (; i < n; i++) {
+        sp->flags[useIndex ? matches[i].index : matches[i].slot] = DELETED;
+        sp->count--;
+        sp->deleted++;
+    }
+    if (sp->autoShrink && sp->size > MIN_SIZE && 8 * sp->count < sp->size)
+        resizeSet(sp, 2 * sp->count > MIN_SIZE ? 2 * sp->count : MIN_SIZE);
+}
+
+/**
+ * Returns the union of two sets, the elements in either set.
+ * The elements of sp2 are looked up in sp1 and only the missing ones are added, so in place sp1 is never scanned.
+ * When an element is in both sets the one from sp1 is kept. The elements themselves are not copied.
+ * Both sets must have been created with the same compare and hash functions.
+ *
+ * @param sp1 the first set, which is changed and returned if inPlace is true
+ * @param sp2 the second set, which is not changed
+ * @param inPlace whether to add to sp1 instead of creating a new set
+ * @return the union, which is a new set the caller must destroy unless inPlace is true
+ * @timeComplexity (O(N1 + N2) + user given hash and compare functions) average case
+ */
+SET* unionSets(SET* sp1, SET* sp2, bool inPlace) {
+    assert(sp1 != NULL && sp2 != NULL);
+    unsigned n;
+    struct match* missing = probeSet(sp2, sp1, false, sp1->threads, &n);
+    SET* result = sp1;
+    if (!inPlace) {
+        result = createSimilarSet(sp1, sp1->count + n);
+        unsigned i = 0;
+        for (; i < sp1->size; i++)
+            if (sp1->flags[i] == FILLED)
+                insertNew(result, sp1->data[i], (*sp1->hash)(sp1->data[i]));
+    } else
+        reserveSet(result, result->count + n + 1);
+    unsigned i = 0;
+    for (; i < n; i++)
+        insertNew(result, sp2->data[missing[i].slot], missing[i].hash);
+    free(missing);
+    return result;
+}
+
+/**
+ * Returns the intersection of two sets, the elements in both sets.
+ * A new intersection is found by scanning the smaller set and looking its elements up in the larger one.
+ * In place, sp1 is scanned whatever its size, because every element of sp1 missing from sp2 has to be found and removed.
+ * The elements kept are the ones from sp1. Both sets must have been created with the same compare and hash functions.
+ *
+ * @param sp1 the first set, which is changed and returned if inPlace is true
+ * @param sp2 the second set, which is not changed
+ * @param inPlace whether to remove from sp1 instead of creating a new set
+ * @return the intersection, which is a new set the caller must destroy unless inPlace is true
+ * @timeComplexity (O(min(N1, N2)) + user given hash and compare functions) average case, or O(N1) in place
+ */
+SET* intersectSets(SET* sp1, SET* sp2, bool inPlace) {
+    assert(sp1 != NULL && sp2 != NULL);
+    unsigned n;
+    if (inPlace) {
+        struct match* missing = probeSet(sp1, sp2, false, sp1->threads, &n);
+        removeSlots(sp1, missing, n, false);
+        free(missing);
+        return sp1;
+    }
+    bool scanFirst = sp1->count <= sp2->count;
+    struct match* common = probeSet(scanFirst ? sp1 : sp2, scanFirst ? sp2 : sp1, true, sp1->threads, &n);
+    SET* result = createSimilarSet(sp1, n);
+    unsigned i = 0;
+    for (; i < n; i++)
+        insertNew(result, sp1->data[scanFirst ? common[i].slot : common[i].index], common[i].hash);
+    free(common);
+    return result;
+}
+
+/**
+ * Returns the difference of two sets, the elements of sp1 that are not in sp2.
+ * In place, whichever set is smaller is scanned: the elements of sp2 are looked up in sp1 and removed,
+ * or the elements of sp1 are looked up in sp2. A new difference must hold most of sp1, so sp1 is scanned.
+ * Both sets must have been created with the same compare and hash functions.
+ *
+ * @param sp1 the first set, which is changed and returned if inPlace is true
+ * @param sp2 the second set, which is not changed
+ * @param inPlace whether to remove from sp1 instead of creating a new set
+ * @return the difference, which is a new set the caller must destroy unless inPlace is true
+ * @timeComplexity (O(min(N1, N2)) + user given hash and compare functions) average case in place, or O(N1)
+ */
+SET* differenceSets(SET* sp1, SET* sp2, bool inPlace) {
+    assert(sp1 != NULL && sp2 != NULL);
+    unsigned n;
+    if (inPlace) {
+        bool scanFirst = sp1->count <= sp2->count;
+        struct match* common = probeSet(scanFirst ? sp1 : sp2, scanFirst ? sp2 : sp1, true, sp1->threads, &n);
+        removeSlots(sp1, common, n, !scanFirst);
+        free(common);
+        return sp1;
+    }
+    struct match* kept = probeSet(sp1, sp2, false, sp1->threads, &n);
+    SET* result = createSimilarSet(sp1, n);
+    unsigned i = 0;
+    for (; i < n; i++)
+        insertNew(result, sp1->data[kept[i].slot], kept[i].hash);
+    free(kept);
+    return result;
+}
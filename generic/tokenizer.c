@@ -0,0 +1,810 @@
+//tokenizer.c
+/**
+ * This file (tokenizer.c) is an implementation for the tokenizer.
+ * The file is read in large blocks and words are found by scanning the block in place,
+ * so a word is never copied; the byte after each word is overwritten with a null so the view is also a C string.
+ * The hash of each word is computed right after it is found, using the same function as the drivers' strhash,
+ * so it can be passed straight to findElementByHash.
+ * Words can be separated by whitespace, by newlines only, or by any character of a given set.
+ * The end of a word is found sixteen bytes at a time with SSE2, or with memchr for lines.
+ * Words can also be normalized, by lowercasing each block in place as it is read and stripping punctuation from
+ * the ends of each word as it is found, before it is hashed.
+ * In UTF-8 mode, the next byte that is not ASCII is found once for each block, so words before it are found exactly as
+ * before.  From there the text is validated sixteen bytes at a time up to the next invalid sequence, and a word before
+ * it is only searched for the lead bytes of Unicode whitespace, which are decoded to split it.  A word that may hold an
+ * invalid sequence is decoded character by character, and must be valid UTF-8 to be returned.
+ *
+ * @author Max Blennemann
+ * @version 10/18/26
+ */
+
+#include "tokenizer.h"
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <stdint.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#define BUFFER_SIZE (1 << 20) // Number of bytes read from the file at a time
+#define MAX_SIMD_DELIMITERS 8 // Largest delimiter set compared one character at a time with SIMD
+
+enum mode {
+    WORDS, // Tokens are separated by whitespace
+    LINES, // Each line is a token, including empty lines
+    DELIMITED // Tokens are separated by any character of a set
+};
+
+typedef struct tokenizer {
+    FILE* fp; // The file being split into words
+    char* buffer; // Bytes read from the file, plus one byte for a null after the last word
+    size_t size; // How much space is allocated to buffer, not counting the extra byte
+    size_t start; // Index of the first byte not yet scanned
+    size_t end; // Number of bytes of buffer that hold data
+    bool eof; // Whether the end of the file has been read
+    enum mode mode; // How the file is split into tokens
+    bool isDelimiter[256]; // Which characters separate tokens in DELIMITED mode
+    char delimiters[MAX_SIMD_DELIMITERS]; // The separating characters, if there are few enough to compare with SIMD
+    int numDelimiters; // Number of characters in delimiters, or 0 if there are too many
+    FILE* out; // Flushed before every read when streaming, or NULL to read in whole blocks
+    void (* beforeRead)(); // Called with beforeReadArg before every read when streaming, or NULL
+    void* beforeReadArg; // Passed to beforeRead
+    bool normalize; // Whether tokens are stripped of punctuation and lowercased
+    bool utf8; // Whether the file is UTF-8 rather than single bytes
+    size_t nonAscii; // In UTF-8 mode, index of the first byte not yet scanned that is not ASCII, or end if none
+    size_t invalid; // In UTF-8 mode, the bytes from nonAscii up to this index are known to be valid UTF-8
+    size_t spaceLead; // In UTF-8 mode, index of the next byte that may start Unicode whitespace, unless it is behind the scan
+    unsigned long line; // The line number of the first byte not yet scanned, counting from 1
+} fileTokenizer;
+
+/**
+ * Returns whether a character separates words, exactly as isspace() does in the C locale.
+ *
+ * @param c the character to check
+ * @return true if c is whitespace
+ * @timeComplexity O(1)
+ */
+static inline bool isSpace(char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+/**
+ * Returns whether a character separates tokens in the tokenizer's mode.
+ *
+ * @param tp the tokenizer
+ * @param c the character to check
+ * @return true if c ends a token
+ * @timeComplexity O(1)
+ */
+static inline bool isDelimiter(TOKENIZER* tp, char c) {
+    if (tp->mode == WORDS)
+        return isSpace(c);
+    if (tp->mode == LINES)
+        return c == '\n';
+    return tp->isDelimiter[(unsigned char) c];
+}
+
+/**
+ * Returns whether a character is ASCII punctuation, exactly as ispunct() does in the C locale.
+ * This is checked at both ends of every normalized token, so it is a single lookup in a table of all 256 bytes,
+ * which measured about twice as fast per token as testing bits of two words.
+ *
+ * @param c the character to check
+ * @return true if c is a printable character other than a letter, digit or space
+ * @timeComplexity O(1)
+ */
+static inline bool isPunct(char c) {
+    static const bool punct[256] = {
+        ['!'] = true, ['"'] = true, ['#'] = true, ['$'] = true, ['%'] = true, ['&'] = true, ['\''] = true,
+        ['('] = true, [')'] = true, ['*'] = true, ['+'] = true, [','] = true, ['-'] = true, ['.'] = true,
+        ['/'] = true, [':'] = true, [';'] = true, ['<'] = true, ['='] = true, ['>'] = true, ['?'] = true,
+        ['@'] = true, ['['] = true, ['\\'] = true, [']'] = true, ['^'] = true, ['_'] = true, ['`'] = true,
+        ['{'] = true, ['|'] = true, ['}'] = true, ['~'] = true
+    };
+    return punct[(unsigned char) c];
+}
+
+#ifdef __SSE2__
+/**
+ * Returns a bit mask of the bytes in a block of sixteen that separate tokens, with bit i set for byte i.
+ * Whitespace is a space or a byte from tab to carriage return, which is tested with one unsigned comparison:
+ * c - '\t' wraps around for bytes below tab, so it is at most 4 only for the five control characters.
+ *
+ * @param tp the tokenizer, in WORDS mode or DELIMITED mode with a short delimiter list
+ * @param p the first byte of the block
+ * @return the mask of delimiters
+ * @timeComplexity O(d) Where d is the number of delimiters
+ */
+static inline unsigned delimiterMask(TOKENIZER* tp, const char* p) {
+    __m128i x = _mm_loadu_si128((const __m128i*) p);
+    __m128i match;
+    if (tp->mode == WORDS) {
+        __m128i shifted = _mm_sub_epi8(x, _mm_set1_epi8('\t'));
+        match = _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8(' ')),
+                             _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8(4)), shifted));
+    } else {
+        match = _mm_setzero_si128();
+        int i = 0;
+        for (; i < tp->numDelimiters; i++)
+            match = _mm_or_si128(match, _mm_cmpeq_epi8(x, _mm_set1_epi8(tp->delimiters[i])));
+    }
+    return _mm_movemask_epi8(match);
+}
+#endif
+
+/**
+ * Returns the index of the first delimiter at or after the given index, or the end of the data if there is none.
+ *
+ * @param tp the tokenizer
+ * @param i where to start looking
+ * @return the index of the delimiter that ends the token
+ * @timeComplexity O(L) Where L is the length of the token
+ */
+static size_t findEnd(TOKENIZER* tp, size_t i) {
+    const char* p = tp->buffer;
+    if (tp->mode == LINES) {
+        const char* newline = memchr(p + i, '\n', tp->end - i);
+        return newline != NULL ? (size_t) (newline - p) : tp->end;
+    }
+#ifdef __SSE2__
+    if (tp->mode == WORDS || tp->numDelimiters > 0) {
+        for (; i + 16 <= tp->end; i += 16) {
+            unsigned mask = delimiterMask(tp, p + i);
+            if (mask != 0)
+                return i + __builtin_ctz(mask);
+        }
+    }
+#endif
+    while (i < tp->end && !isDelimiter(tp, p[i]))
+        i++;
+    return i;
+}
+
+/**
+ * Lowercases the ASCII letters in part of the buffer, in place, leaving any letters that are delimiters alone.
+ * This is done once for each block as it is read, so tokens are already lowercase when they are found and hashed.
+ * Sixteen bytes are folded at a time with SSE2: a byte is an upper case letter if it is greater than '@' and
+ * less than '[' as a signed byte, so bytes above 127 are left alone, and 0x20 is or'ed into those that are.
+ *
+ * @param tp the tokenizer
+ * @param i the index of the first byte to fold
+ * @param n the index after the last byte to fold
+ * @timeComplexity O(n - i)
+ */
+static void foldCase(TOKENIZER* tp, size_t i, size_t n) {
+    char* s = tp->buffer;
+#ifdef __SSE2__
+    if (tp->mode != DELIMITED || tp->numDelimiters > 0) {
+        for (; i + 16 <= n; i += 16) {
+            __m128i x = _mm_loadu_si128((const __m128i*) (s + i));
+            __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(x, _mm_set1_epi8('A' - 1)),
+                                          _mm_cmplt_epi8(x, _mm_set1_epi8('Z' + 1)));
+            int d = 0;
+            if (tp->mode == DELIMITED)
+                for (; d < tp->numDelimiters; d++)
+                    upper = _mm_andnot_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8(tp->delimiters[d])), upper);
+            _mm_storeu_si128((__m128i*) (s + i), _mm_or_si128(x, _mm_and_si128(upper, _mm_set1_epi8(0x20))));
+        }
+    }
+#endif
+    for (; i < n; i++)
+        if (s[i] >= 'A' && s[i] <= 'Z' && !isDelimiter(tp, s[i]))
+            s[i] |= 0x20;
+}
+
+/**
+ * Moves the start and end of a token past any punctuation at either end of it.
+ *
+ * @param s the buffer holding the token
+ * @param start the index of the first byte of the token
+ * @param end the index after the last byte of the token
+ * @timeComplexity O(P) Where P is the number of punctuation characters stripped
+ */
+static inline void stripPunct(const char* s, size_t* start, size_t* end) {
+    while (*start < *end && isPunct(s[*start]))
+        (*start)++;
+    while (*end > *start && isPunct(s[*end - 1]))
+        (*end)--;
+}
+
+/**
+ * Returns the index of the first byte at or after i that is not ASCII, or n if there is none.
+ * Sixteen bytes are checked at a time with SSE2, since the high bit of each byte is gathered by one movemask.
+ *
+ * @param s the buffer
+ * @param i where to start looking
+ * @param n the index after the last byte to check
+ * @return the index of the first byte with its high bit set
+ * @timeComplexity O(n - i)
+ */
+static inline size_t findNonAscii(const char* s, size_t i, size_t n) {
+#ifdef __SSE2__
+    for (; i + 16 <= n; i += 16) {
+        unsigned mask = _mm_movemask_epi8(_mm_loadu_si128((const __m128i*) (s + i)));
+        if (mask != 0)
+            return i + __builtin_ctz(mask);
+    }
+#endif
+    while (i < n && (unsigned char) s[i] < 0x80)
+        i++;
+    return i;
+}
+
+/**
+ * Decodes one UTF-8 character.
+ * Overlong encodings, surrogates, and code points above U+10FFFF are invalid, as are truncated sequences.
+ *
+ * @param s the first byte of the character
+ * @param n the number of bytes available
+ * @param cp set to the code point
+ * @return the number of bytes in the character, or 0 if it is not valid UTF-8
+ * @timeComplexity O(1)
+ */
+static size_t decodeUtf8(const char* s, size_t n, uint32_t* cp) {
+    const unsigned char* u = (const unsigned char*) s;
+    size_t length;
+    uint32_t min;
+    if (u[0] < 0x80) {
+        *cp = u[0];
+        return 1;
+    } else if (u[0] >= 0xC2 && u[0] <= 0xDF) {
+        length = 2;
+        min = 0x80;
+        *cp = u[0] & 0x1F;
+    } else if ((u[0] & 0xF0) == 0xE0) {
+        length = 3;
+        min = 0x800;
+        *cp = u[0] & 0x0F;
+    } else if (u[0] >= 0xF0 && u[0] <= 0xF4) {
+        length = 4;
+        min = 0x10000;
+        *cp = u[0] & 0x07;
+    } else
+        return 0;
+    if (n < length)
+        return 0;
+    size_t i = 1;
+    for (; i < length; i++) {
+        if ((u[i] & 0xC0) != 0x80)
+            return 0;
+        *cp = *cp << 6 | (u[i] & 0x3F);
+    }
+    if (*cp < min || *cp > 0x10FFFF || (*cp >= 0xD800 && *cp <= 0xDFFF))
+        return 0;
+    return length;
+}
+
+/**
+ * Returns the index of the first character at or after a character boundary that may not be valid UTF-8, or n if
+ * every character up to n is valid and complete.
+ * Sixteen bytes are checked at a time with SSE2 by classifying each byte with unsigned comparisons: a byte must be a
+ * continuation byte exactly when one of the three bytes before it is a lead byte that expects it, bytes that are
+ * never valid are rejected, and the second byte after E0, ED, F0 and F4 is checked for overlong forms, surrogates
+ * and code points above U+10FFFF.  Since an error is noticed at the byte where it shows, the index returned is moved
+ * back by the length of the longest sequence, so any word holding the invalid bytes ends after it.
+ * The last few bytes are decoded one character at a time.
+ *
+ * @param s the buffer
+ * @param i where to start checking, which must be the first byte of a character
+ * @param n the index after the last byte to check
+ * @return an index at or before the first invalid sequence
+ * @timeComplexity O(n - i)
+ */
+static size_t findInvalidUtf8(const char* s, size_t i, size_t n) {
+    size_t from = i;
+#ifdef __SSE2__
+    __m128i prev = _mm_setzero_si128();
+    for (; i + 16 <= n; i += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i*) (s + i));
+        if (_mm_movemask_epi8(_mm_or_si128(x, prev)) == 0)
+            continue;
+        __m128i prev1 = _mm_or_si128(_mm_slli_si128(x, 1), _mm_srli_si128(prev, 15));
+        __m128i prev2 = _mm_or_si128(_mm_slli_si128(x, 2), _mm_srli_si128(prev, 14));
+        __m128i prev3 = _mm_or_si128(_mm_slli_si128(x, 3), _mm_srli_si128(prev, 13));
+        __m128i expected = _mm_or_si128(_mm_or_si128(
+                               _mm_cmpeq_epi8(_mm_max_epu8(prev1, _mm_set1_epi8(0xC0)), prev1),
+                               _mm_cmpeq_epi8(_mm_max_epu8(prev2, _mm_set1_epi8(0xE0)), prev2)),
+                               _mm_cmpeq_epi8(_mm_max_epu8(prev3, _mm_set1_epi8(0xF0)), prev3));
+        __m128i below90 = _mm_cmpeq_epi8(_mm_max_epu8(x, _mm_set1_epi8(0x8F)), _mm_set1_epi8(0x8F));
+        __m128i belowA0 = _mm_cmpeq_epi8(_mm_max_epu8(x, _mm_set1_epi8(0x9F)), _mm_set1_epi8(0x9F));
+        __m128i error = _mm_xor_si128(expected, _mm_cmplt_epi8(x, _mm_set1_epi8(0xC0))); // continuation bytes
+        error = _mm_or_si128(error, _mm_cmpeq_epi8(_mm_max_epu8(x, _mm_set1_epi8(0xF5)), x));
+        error = _mm_or_si128(error, _mm_cmpeq_epi8(_mm_and_si128(x, _mm_set1_epi8(0xFE)), _mm_set1_epi8(0xC0)));
+        error = _mm_or_si128(error, _mm_and_si128(_mm_cmpeq_epi8(prev1, _mm_set1_epi8(0xE0)), belowA0));
+        error = _mm_or_si128(error, _mm_andnot_si128(belowA0, _mm_cmpeq_epi8(prev1, _mm_set1_epi8(0xED))));
+        error = _mm_or_si128(error, _mm_and_si128(_mm_cmpeq_epi8(prev1, _mm_set1_epi8(0xF0)), below90));
+        error = _mm_or_si128(error, _mm_andnot_si128(below90, _mm_cmpeq_epi8(prev1, _mm_set1_epi8(0xF4))));
+        unsigned mask = _mm_movemask_epi8(error);
+        if (mask != 0) {
+            i += __builtin_ctz(mask);
+            return i >= from + 3 ? i - 3 : from;
+        }
+        prev = x;
+    }
+    int back = 1;
+    for (; back <= 3 && i >= from + back; back++)
+        if ((unsigned char) s[i - back] >= 0xC0) {
+            i -= back; // a character that continues past the last block
+            break;
+        }
+#endif
+    while (i < n) {
+        uint32_t cp;
+        size_t length = decodeUtf8(s + i, n - i, &cp);
+        if (length == 0)
+            return i;
+        i = findNonAscii(s, i + length, n);
+    }
+    return n;
+}
+
+/**
+ * Returns the index of the first byte at or after i that may start a Unicode whitespace character, or n if there
+ * is none.  Those all start with C2, E1, E2 or E3, which are found sixteen bytes at a time with SSE2.
+ *
+ * @param s the buffer
+ * @param i where to start looking
+ * @param n the index after the last byte to check
+ * @return the index of the first possible whitespace character
+ * @timeComplexity O(n - i)
+ */
+static inline size_t findSpaceLead(const char* s, size_t i, size_t n) {
+#ifdef __SSE2__
+    for (; i + 16 <= n; i += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i*) (s + i));
+        __m128i shifted = _mm_sub_epi8(x, _mm_set1_epi8(0xE1));
+        unsigned mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8(0xC2)),
+                                          _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8(2)), shifted)));
+        if (mask != 0)
+            return i + __builtin_ctz(mask);
+    }
+#endif
+    while (i < n && (unsigned char) s[i] != 0xC2 && (unsigned char) (s[i] - 0xE1) > 2)
+        i++;
+    return i;
+}
+
+/**
+ * Returns whether a code point above ASCII is whitespace, as given by the White_Space property of Unicode.
+ *
+ * @param cp the code point
+ * @return true if cp is a space, line separator or paragraph separator
+ * @timeComplexity O(1)
+ */
+static inline bool isUnicodeSpace(uint32_t cp) {
+    return cp == 0x85 || cp == 0xA0 || cp == 0x1680 || (cp >= 0x2000 && cp <= 0x200A) || cp == 0x2028 ||
+           cp == 0x2029 || cp == 0x202F || cp == 0x205F || cp == 0x3000;
+}
+
+/**
+ * Returns whether a code point above ASCII is punctuation.
+ * This covers the General Punctuation block and the common punctuation of Latin-1, Greek, Armenian, CJK text, and
+ * full width forms, which is what is found around words in practice, rather than every character in category P.
+ *
+ * @param cp the code point
+ * @return true if cp is punctuation
+ * @timeComplexity O(1)
+ */
+static bool isUnicodePunct(uint32_t cp) {
+    static const uint32_t ranges[][2] = {
+        {0xA1, 0xA1}, {0xA7, 0xA7}, {0xAB, 0xAB}, {0xB6, 0xB7}, {0xBB, 0xBB}, {0xBF, 0xBF},
+        {0x37E, 0x37E}, {0x387, 0x387}, {0x55A, 0x55F}, {0x589, 0x58A}, {0x2010, 0x2027}, {0x2030, 0x205E},
+        {0x3001, 0x3003}, {0x3008, 0x3011}, {0x3014, 0x301F}, {0xFF01, 0xFF03}, {0xFF05, 0xFF0A},
+        {0xFF0C, 0xFF0F}, {0xFF1A, 0xFF1B}, {0xFF1F, 0xFF20}
+    };
+    size_t i = 0;
+    for (; i < sizeof(ranges) / sizeof(ranges[0]) && cp >= ranges[i][0]; i++)
+        if (cp <= ranges[i][1])
+            return true;
+    return false;
+}
+
+/**
+ * Returns whether a byte may start a character that isUnicodePunct accepts, so other characters need not be decoded.
+ * Those start with C2, CD, CE, D5, D6, E2, E3 or EF, which are kept as bits of a word indexed from C0.
+ *
+ * @param c the first byte of a character
+ * @return true if the character may be punctuation
+ * @timeComplexity O(1)
+ */
+static inline bool isPunctLead(char c) {
+    unsigned char u = c;
+    return u >= 0xC0 && (0x800C00606004ULL >> (u - 0xC0) & 1);
+}
+
+/**
+ * Returns the simple lower case form of an upper case letter from Latin-1, Latin Extended-A, Greek or Cyrillic.
+ * Each of these letters and its lower case form are both two bytes long, so a word can be folded in place.
+ *
+ * @param cp the code point
+ * @return the lower case code point, or cp if it has none in these blocks
+ * @timeComplexity O(1)
+ */
+static uint32_t foldCodePoint(uint32_t cp) {
+    if ((cp >= 0xC0 && cp <= 0xDE && cp != 0xD7) || (cp >= 0x391 && cp <= 0x3AB && cp != 0x3A2) ||
+        (cp >= 0x410 && cp <= 0x42F))
+        return cp + 0x20;
+    if (cp >= 0x400 && cp <= 0x40F)
+        return cp + 0x50;
+    if (cp == 0x178)
+        return 0xFF;
+    if ((cp >= 0x100 && cp <= 0x12F) || (cp >= 0x132 && cp <= 0x137) || (cp >= 0x14A && cp <= 0x177))
+        return cp | 1; // upper case letters are even and followed by their lower case forms
+    if ((cp >= 0x139 && cp <= 0x148) || (cp >= 0x179 && cp <= 0x17E))
+        return cp & 1 ? cp + 1 : cp; // here the upper case letters are odd
+    return cp;
+}
+
+/**
+ * Checks the part of a token after its first non-ASCII byte, cutting it short at any Unicode whitespace
+ * unless the file is being split into lines.
+ * If the text has been validated past the end of the token, only possible whitespace characters are decoded,
+ * which are found ahead of the token as well so that most tokens are not searched at all;
+ * otherwise it is validated from here up to its next invalid sequence first.
+ *
+ * @param tp the tokenizer
+ * @param i the index of the first non-ASCII byte of the token
+ * @param end the index after the last byte of the token, moved back to the whitespace if there is any
+ * @param next set to the index after the whitespace, if there is any
+ * @return true if the token, up to its new end, is valid UTF-8
+ * @timeComplexity O(L) Where L is the length of the token
+ */
+static bool scanUtf8(TOKENIZER* tp, size_t i, size_t* end, size_t* next) {
+    const char* s = tp->buffer;
+    uint32_t cp;
+    size_t n;
+    if (i >= tp->invalid)
+        tp->invalid = findInvalidUtf8(s, i, tp->end);
+    if (*end <= tp->invalid) {
+        if (tp->mode == LINES)
+            return true;
+        if (tp->spaceLead < i)
+            tp->spaceLead = findSpaceLead(s, i, tp->end);
+        for (i = tp->spaceLead; i < *end; i = tp->spaceLead = findSpaceLead(s, i + n, tp->end)) {
+            n = decodeUtf8(s + i, *end - i, &cp);
+            if (isUnicodeSpace(cp)) {
+                *next = i + n;
+                *end = i;
+                break;
+            }
+        }
+        return true;
+    }
+    bool valid = true;
+    while (i < *end) {
+        n = decodeUtf8(s + i, *end - i, &cp);
+        if (n == 0) {
+            valid = false;
+            n = 1;
+        } else if (tp->mode != LINES && isUnicodeSpace(cp)) {
+            *next = i + n;
+            *end = i;
+            break;
+        }
+        i = findNonAscii(s, i + n, *end);
+    }
+    return valid;
+}
+
+/**
+ * Strips ASCII and Unicode punctuation from both ends of a valid UTF-8 token, and folds its letters to lower case
+ * in place.  The ASCII letters have already been folded as the block was read.
+ * Every upper case letter foldCodePoint knows starts with C3, C4, C5, CE or D0, and since the token is valid no
+ * continuation byte looks like one, so only characters with those lead bytes are decoded.
+ *
+ * @param s the buffer holding the token
+ * @param start the index of the first byte of the token
+ * @param end the index after the last byte of the token
+ * @timeComplexity O(L) Where L is the length of the token
+ */
+static void normalizeUtf8(char* s, size_t* start, size_t* end) {
+    uint32_t cp;
+    size_t n;
+    for (;;) {
+        stripPunct(s, start, end);
+        if (*start < *end && isPunctLead(s[*start]) && (n = decodeUtf8(s + *start, *end - *start, &cp)) > 1 &&
+            isUnicodePunct(cp)) {
+            *start += n;
+            continue;
+        }
+        size_t last = *end;
+        while (last > *start && *end - last < 4 && ((unsigned char) s[last - 1] & 0xC0) == 0x80)
+            last--;
+        if (last > *start && isPunctLead(s[last - 1]) && (n = decodeUtf8(s + last - 1, *end - last + 1, &cp)) > 1 &&
+            isUnicodePunct(cp)) {
+            *end = last - 1;
+            continue;
+        }
+        break;
+    }
+    size_t i = *start;
+    for (; i + 1 < *end; i++) {
+        unsigned char lead = s[i];
+        if (lead == 0xC3 || lead == 0xC4 || lead == 0xC5 || lead == 0xCE || lead == 0xD0) {
+            cp = (lead & 0x1F) << 6 | (s[i + 1] & 0x3F);
+            uint32_t lower = foldCodePoint(cp);
+            if (lower != cp) {
+                s[i] = 0xC0 | lower >> 6;
+                s[i + 1] = 0x80 | (lower & 0x3F);
+            }
+            i++;
+        }
+    }
+}
+
+/**
+ * Returns the same hash value as the drivers' strhash for the given bytes.
+ * Four characters are folded in per step using powers of 31, which shortens the chain of dependent multiplies.
+ *
+ * @param s the first character
+ * @param n the number of characters
+ * @return the hash value
+ * @timeComplexity O(n)
+ */
+static inline unsigned hashBytes(const char* s, size_t n) {
+    unsigned hash = 0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+        hash = hash * (31u * 31 * 31 * 31) + s[i] * (31u * 31 * 31) + s[i + 1] * (31u * 31) + s[i + 2] * 31u + s[i + 3];
+    for (; i < n; i++)
+        hash = 31 * hash + s[i];
+    return hash;
+}
+
+/**
+ * Returns a new tokenizer that reads words from the given file.
+ * The file is not closed by destroyTokenizer.
+ *
+ * @param fp the file to read
+ * @return the newly allocated tokenizer
+ * @timeComplexity O(1)
+ */
+TOKENIZER* createTokenizer(FILE* fp) {
+    assert(fp != NULL);
+    fileTokenizer* a = malloc(sizeof(fileTokenizer));
+    assert(a != NULL);
+    a->fp = fp;
+    a->size = BUFFER_SIZE;
+    a->buffer = malloc(a->size + 1);
+    assert(a->buffer != NULL);
+    a->start = 0;
+    a->end = 0;
+    a->eof = false;
+    a->mode = WORDS;
+    a->numDelimiters = 0;
+    a->out = NULL;
+    a->beforeRead = NULL;
+    a->beforeReadArg = NULL;
+    a->normalize = false;
+    a->utf8 = false;
+    a->nonAscii = 0;
+    a->invalid = 0;
+    a->spaceLead = 0;
+    a->line = 1;
+    return a;
+}
+
+/**
+ * Frees the memory allocated to the tokenizer.
+ *
+ * @param tp the tokenizer to destroy
+ * @timeComplexity O(1)
+ */
+void destroyTokenizer(TOKENIZER* tp) {
+    assert(tp != NULL);
+    free(tp->buffer);
+    free(tp);
+}
+
+/**
+ * Moves the bytes not yet scanned to the front of the buffer and reads more of the file after them.
+ * The buffer is doubled if a single word fills all of it.
+ *
+ * @param tp the tokenizer to refill
+ * @timeComplexity O(B) Where B is the size of the buffer
+ */
+static void refill(TOKENIZER* tp) {
+    size_t remaining = tp->end - tp->start;
+    memmove(tp->buffer, tp->buffer + tp->start, remaining);
+    tp->start = 0;
+    tp->end = remaining;
+    if (tp->end == tp->size) {
+        tp->size *= 2;
+        tp->buffer = realloc(tp->buffer, tp->size + 1);
+        assert(tp->buffer != NULL);
+    }
+    size_t n;
+    if (tp->out != NULL) {
+        if (tp->beforeRead != NULL)
+            (*tp->beforeRead)(tp->beforeReadArg);
+        fflush(tp->out);
+        ssize_t got;
+        while ((got = read(fileno(tp->fp), tp->buffer + tp->end, tp->size - tp->end)) < 0 && errno == EINTR)
+            ;
+        n = got > 0 ? got : 0;
+    } else
+        n = fread(tp->buffer + tp->end, 1, tp->size - tp->end, tp->fp);
+    if (tp->normalize)
+        foldCase(tp, tp->end, tp->end + n);
+    tp->end += n;
+    if (tp->utf8)
+        tp->nonAscii = findNonAscii(tp->buffer, 0, tp->end);
+    tp->invalid = 0;
+    tp->spaceLead = 0;
+    if (n == 0)
+        tp->eof = true;
+}
+
+/**
+ * Makes each line of the file a token, instead of each whitespace separated word.
+ * The newline is not part of the token, and empty lines are returned as empty tokens.
+ *
+ * @param tp the tokenizer to modify
+ * @param enabled whether to split the file into lines
+ * @timeComplexity O(1)
+ */
+void setTokenizerLines(TOKENIZER* tp, bool enabled) {
+    assert(tp != NULL);
+    tp->mode = enabled ? LINES : WORDS;
+}
+
+/**
+ * Makes tokens be separated by any character of the given set, instead of by whitespace.
+ * A newline always ends a token as well, so no token spans lines.
+ * Runs of delimiters are skipped, so there are no empty tokens.
+ *
+ * @param tp the tokenizer to modify
+ * @param delimiters the characters that separate tokens, or NULL to go back to whitespace
+ * @timeComplexity O(d) Where d is the number of delimiters
+ */
+void setTokenizerDelimiters(TOKENIZER* tp, const char* delimiters) {
+    assert(tp != NULL);
+    if (delimiters == NULL) {
+        tp->mode = WORDS;
+        return;
+    }
+    assert(*delimiters != '\0');
+    tp->mode = DELIMITED;
+    memset(tp->isDelimiter, false, sizeof(tp->isDelimiter));
+    tp->isDelimiter['\n'] = true;
+    tp->delimiters[0] = '\n';
+    tp->numDelimiters = 1;
+    for (; *delimiters != '\0'; delimiters++) {
+        unsigned char c = *delimiters;
+        if (!tp->isDelimiter[c] && tp->numDelimiters >= 0) {
+            if (tp->numDelimiters < MAX_SIMD_DELIMITERS)
+                tp->delimiters[tp->numDelimiters++] = c;
+            else
+                tp->numDelimiters = -1; // too many to compare one at a time
+        }
+        tp->isDelimiter[c] = true;
+    }
+    if (tp->numDelimiters < 0)
+        tp->numDelimiters = 0;
+}
+
+/**
+ * Makes the tokenizer strip leading and trailing punctuation from each token and lowercase its ASCII letters,
+ * so that "Macbeth", "Macbeth," and "MACBETH." are the same word.
+ * A word made only of punctuation is skipped; a line made only of punctuation is returned as an empty token.
+ *
+ * @param tp the tokenizer to modify
+ * @param enabled whether to normalize tokens
+ * @timeComplexity O(1)
+ */
+void setTokenizerNormalize(TOKENIZER* tp, bool enabled) {
+    assert(tp != NULL);
+    if (enabled && !tp->normalize)
+        foldCase(tp, tp->start, tp->end);
+    tp->normalize = enabled;
+}
+
+/**
+ * Makes the tokenizer treat the file as UTF-8.
+ * Words are also separated by Unicode whitespace, a word that is not valid UTF-8 is skipped, and normalizing also
+ * strips Unicode punctuation and folds the case of Latin-1, Latin Extended-A, Greek and Cyrillic letters.
+ * Words before the next byte that is not ASCII are not looked at again, so ASCII text costs almost nothing extra.
+ *
+ * @param tp the tokenizer to modify
+ * @param enabled whether the file is UTF-8
+ * @timeComplexity O(1)
+ */
+void setTokenizerUtf8(TOKENIZER* tp, bool enabled) {
+    assert(tp != NULL);
+    tp->utf8 = enabled;
+    tp->nonAscii = findNonAscii(tp->buffer, tp->start, tp->end);
+    tp->invalid = 0;
+    tp->spaceLead = 0;
+}
+
+/**
+ * Makes the tokenizer suitable for a filter reading from a pipe or terminal.
+ * Instead of waiting for a whole block, each read returns as soon as any input is available,
+ * and the given output is flushed first, so nothing written for earlier tokens is held back while the input is waited on.
+ * The file is then read with read() on its descriptor, so nothing may have been read from it through stdio.
+ *
+ * @param tp the tokenizer to modify
+ * @param out the output to flush before each read, or NULL to go back to reading whole blocks
+ * @timeComplexity O(1)
+ */
+void setTokenizerStreaming(TOKENIZER* tp, FILE* out) {
+    assert(tp != NULL);
+    tp->out = out;
+}
+
+/**
+ * Sets a function called before each read when streaming, before the output is flushed.
+ * A caller that holds back its output for a batch of words can write the batch out from it,
+ * so nothing is left unwritten while the tokenizer waits on a pipe for input that may depend on that output.
+ *
+ * @param tp the tokenizer to modify
+ * @param beforeRead called as beforeRead(arg) before each read, or NULL for nothing
+ * @param arg passed to beforeRead
+ * @timeComplexity O(1)
+ */
+void setTokenizerBeforeRead(TOKENIZER* tp, void (* beforeRead)(), void* arg) {
+    assert(tp != NULL);
+    tp->beforeRead = beforeRead;
+    tp->beforeReadArg = arg;
+}
+
+/**
+ * Finds the next word, or line, in the file.
+ * The text of the word is null terminated and stays valid until the next call.
+ *
+ * @param tp the tokenizer to read from
+ * @param tok filled in with the text, length, hash value and line number of the word
+ * @return true if a word was found, or false at the end of the file
+ * @timeComplexity O(L) Where L is the number of bytes up to the end of the word
+ */
+bool nextToken(TOKENIZER* tp, struct token* tok) {
+    assert(tp != NULL);
+    assert(tok != NULL);
+    for (;;) {
+        if (tp->mode != LINES)
+            while (tp->start < tp->end && isDelimiter(tp, tp->buffer[tp->start]))
+                tp->line += tp->buffer[tp->start++] == '\n';
+        if (tp->start == tp->end) {
+            if (tp->eof)
+                return false;
+            refill(tp);
+            continue;
+        }
+        size_t i = findEnd(tp, tp->start);
+        if (i == tp->end && !tp->eof) {
+            refill(tp); // the word may continue in the next block
+            continue;
+        }
+        size_t start = tp->start, end = i;
+        unsigned long line = tp->line;
+        tp->start = i < tp->end ? i + 1 : i;
+        bool ascii = true, valid = true;
+        if (tp->utf8 && tp->nonAscii < start)
+            tp->nonAscii = findNonAscii(tp->buffer, start, tp->end); // skipped a delimiter that is not ASCII
+        if (tp->utf8 && tp->nonAscii < end) {
+            ascii = false;
+            valid = scanUtf8(tp, tp->nonAscii, &end, &tp->start);
+            tp->nonAscii = findNonAscii(tp->buffer, tp->start, tp->end);
+        }
+        if (tp->start == i + 1 && tp->buffer[i] == '\n')
+            tp->line++; // unless the word ended at Unicode whitespace, and the newline is still ahead
+        if (!valid)
+            continue;
+        if (tp->normalize) {
+            if (ascii)
+                stripPunct(tp->buffer, &start, &end);
+            else
+                normalizeUtf8(tp->buffer, &start, &end);
+        }
+        if (start == end && tp->mode != LINES)
+            continue;
+        tok->text = tp->buffer + start;
+        tok->length = end - start;
+        tok->hash = hashBytes(tok->text, tok->length);
+        tok->line = line;
+        tp->buffer[end] = '\0';
+        return true;
+    }
+}
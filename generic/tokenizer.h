@@ -0,0 +1,49 @@
+/*
+ * File:        tokenizer.h
+ *
+ * Description: This file contains the public function and type
+ *              declarations for a tokenizer that splits a file into
+ *              whitespace-separated words like fscanf("%s") does.  Words
+ *              are returned as views into the tokenizer's buffer along with
+ *              their length, hash value and line number, so no word is
+ *              copied.  The tokenizer can also return whole lines or split
+ *              on a given set of delimiters, can lowercase words and strip
+ *              punctuation from them, can treat the file as UTF-8, and can
+ *              read from a pipe without waiting for a full block.
+ */
+
+# ifndef TOKENIZER_H
+# define TOKENIZER_H
+
+# include <stdio.h>
+# include <stddef.h>
+# include <stdbool.h>
+
+typedef struct tokenizer TOKENIZER;
+
+struct token {
+    char *text;
+    size_t length;
+    unsigned hash;
+    unsigned long line;
+};
+
+TOKENIZER *createTokenizer(FILE *fp);
+
+void destroyTokenizer(TOKENIZER *tp);
+
+void setTokenizerLines(TOKENIZER *tp, bool enabled);
+
+void setTokenizerDelimiters(TOKENIZER *tp, const char *delimiters);
+
+void setTokenizerNormalize(TOKENIZER *tp, bool enabled);
+
+void setTokenizerUtf8(TOKENIZER *tp, bool enabled);
+
+void setTokenizerStreaming(TOKENIZER *tp, FILE *out);
+
+void setTokenizerBeforeRead(TOKENIZER *tp, void (*beforeRead)(), void *arg);
+
+bool nextToken(TOKENIZER *tp, struct token *tok);
+
+# endif /* TOKENIZER_H */
@@ -6,12 +6,44 @@
  * Description: This file contains the main function for testing a set
  *              abstract data type for strings.
  *
- *              The program takes two files as command line arguments, the
- *              second of which is optional.  All words in the first file
- *              are inserted into the set and the counts of total words and
- *              total words in the set are printed.  If the second file is
- *              given then all words in the second file are deleted from
- *              the set and the count printed.
+ *              The program takes one or more files as command line
+ *              arguments.  All words in the first file are inserted into
+ *              the set and the counts of total words and total words in
+ *              the set are printed.  The words of each further file are
+ *              put in a set of their own and combined with the first set,
+ *              by default by deleting them from it (-d), or by keeping only
+ *              the words in both (-i), or by adding them (-u), and the
+ *              final count is printed.  Any file may be a corpus file
+ *              written by encode.
+ *
+ *              With the -f option the program instead writes each word of
+ *              a single file, or of the standard input, the first time it
+ *              appears, like awk '!seen[$0]++' does for lines.  The -F
+ *              option does the same for whole lines.
+ *
+ *              Words are separated by whitespace, unless the --lines
+ *              option makes each line a word or the --delim option gives
+ *              the characters that separate words.  The --normalize
+ *              option lowercases words and strips punctuation from their
+ *              ends as they are read, and the --utf8 option also splits at
+ *              Unicode whitespace, folds non-ASCII letters and skips words
+ *              that are not valid UTF-8.
+ *
+ *              With the -m option a single file is read using about the
+ *              given number of megabytes for its distinct words.  Words
+ *              that do not fit are sorted and spilled to temporary files,
+ *              which are merged at the end, so the counts are exact and
+ *              -l lists the words in sorted order.
+ *
+ *              With the --query option the words of the given dictionary
+ *              are loaded into a set once, and each word of a file, or of
+ *              the standard input, is printed with whether it is in the
+ *              set, or only the words in it are printed (--hits) or only
+ *              the words not in it (--misses).  The words are looked up
+ *              in batches whose slots are prefetched together, and a
+ *              batch is answered early whenever more input has to be
+ *              read, so a program feeding words through a pipe gets
+ *              every answer without closing it.
  */
 
 # include <stdio.h>
@@ -19,6 +51,11 @@
 # include <string.h>
 # include <stdbool.h>
 # include "set.h"
+# include "estimate.h"
+# include "corpus.h"
+# include "pool.h"
+# include "tokenizer.h"
+# include "spill.h"
 
 
 /* This is sufficient for the test cases in /scratch/coen12. */
@@ -26,6 +63,11 @@
 # define MAX_SIZE 18000
 
 
+/* Query words are looked up this many at a time. */
+
+# define QUERY_BATCH 64
+
+
 /*
  * Function:    strhash
  *
@@ -44,6 +86,372 @@ static unsigned strhash(char *s)
 }
 
 
+/* The words in every set, which are freed all at once at the end. */
+
+static POOL *pool;
+
+
+/* How text files are split into words, set by --lines, --delim,
+   --normalize and --utf8. */
+
+static bool lines, normalize, utf8;
+static char *delimiters;
+
+
+/* Set when a corpus file turns out to be truncated or corrupt, so that
+   nothing is printed as if the file had been read. */
+
+static bool corrupt;
+
+
+/*
+ * Function:	copyWord
+ *
+ * Description:	Return a copy of a word being added to a set.
+ */
+
+static void *copyWord(char *word)
+{
+    return allocString(pool, word, strlen(word));
+}
+
+
+/*
+ * Function:	openTokenizer
+ *
+ * Description:	Return a new tokenizer for the file FP that splits it into
+ *		lines or at the delimiters if asked to.
+ */
+
+static TOKENIZER *openTokenizer(FILE *fp)
+{
+    TOKENIZER *tp;
+
+
+    tp = createTokenizer(fp);
+    setTokenizerLines(tp, lines);
+    setTokenizerNormalize(tp, normalize);
+    setTokenizerUtf8(tp, utf8);
+
+    if (delimiters != NULL)
+	setTokenizerDelimiters(tp, delimiters);
+
+    return tp;
+}
+
+
+/*
+ * Function:	readWords
+ *
+ * Description:	Return a new set of the words in the file FP, and add the
+ *		number of words in the file to WORDS.  A corpus file
+ *		already lists its distinct words, so only those need to be
+ *		inserted.  The set is sized from a sample of a text file if
+ *		SFLAG is true.  Return NULL and set CORRUPT if the file is
+ *		a truncated or corrupt corpus file.
+ */
+
+static SET *readWords(FILE *fp, bool sflag, int *words)
+{
+    TOKENIZER *tp;
+    struct token tok;
+    CORPUS *corpus;
+    SET *sp;
+    char *word;
+    int i, size;
+
+
+    if ((corpus = openCorpus(fp)) != NULL) {
+	if (corpusError(corpus)) {
+	    destroyCorpus(corpus);
+	    corrupt = true;
+	    return NULL;
+	}
+
+	*words += numCorpusTokens(corpus);
+	sp = createSet(numCorpusWords(corpus) * 4 / 3 + 1, strcmp, strhash);
+
+	for (i = 0; i < numCorpusWords(corpus); i ++) {
+	    word = corpusWord(corpus, i);
+	    addElement(sp, allocString(pool, word, strlen(word)));
+	}
+
+	destroyCorpus(corpus);
+	return sp;
+    }
+
+    size = sflag ? estimateWords(fp, MAX_SIZE) * 4 / 3 + 1 : MAX_SIZE;
+    sp = createSet(size, strcmp, strhash);
+
+    setCopyFunction(sp, copyWord);
+    tp = openTokenizer(fp);
+
+    while (nextToken(tp, &tok)) {
+	(*words) ++;
+	addElement(sp, tok.text);
+    }
+
+    destroyTokenizer(tp);
+    return sp;
+}
+
+
+/*
+ * Function:	spillWords
+ *
+ * Description:	Print the number of words and distinct words in the file
+ *		FP, or if LFLAG is true, the distinct words in sorted order,
+ *		keeping about BUDGET bytes of words in memory.  Return false
+ *		if the words that were spilled could not be written.  Set
+ *		CORRUPT instead if the file is a truncated or corrupt corpus.
+ */
+
+static bool spillWords(FILE *fp, size_t budget, bool lflag)
+{
+    TOKENIZER *tp;
+    CORPUS *corpus;
+    SPILL *sp;
+    struct token tok;
+    char *word;
+    long words, distinct, count;
+    int i;
+
+
+    sp = createSpill(budget);
+    words = 0;
+
+    if ((corpus = openCorpus(fp)) != NULL) {
+	if (corpusError(corpus)) {
+	    destroyCorpus(corpus);
+	    destroySpill(sp);
+	    corrupt = true;
+	    return true;
+	}
+
+	words = numCorpusTokens(corpus);
+
+	for (i = 0; i < numCorpusWords(corpus); i ++)
+	    addToSpill(sp, corpusWord(corpus, i), 1);
+
+	destroyCorpus(corpus);
+
+    } else {
+	tp = openTokenizer(fp);
+
+	while (nextToken(tp, &tok)) {
+	    words ++;
+	    addToSpill(sp, tok.text, 1);
+	}
+
+	destroyTokenizer(tp);
+    }
+
+    if (!finishSpill(sp)) {
+	destroySpill(sp);
+	return false;
+    }
+
+    distinct = 0;
+
+    while (nextSpilled(sp, &word, &count)) {
+	distinct ++;
+
+	if (lflag)
+	    printf("%s\n", word);
+    }
+
+    if (!lflag) {
+	printf("%ld total words\n", words);
+	printf("%ld distinct words\n", distinct);
+    }
+
+    destroySpill(sp);
+    return true;
+}
+
+
+/*
+ * Function:	firstOccurrences
+ *
+ * Description:	Write each word of the file FP the first time it appears,
+ *		in one pass.  Words come straight from the tokenizer's
+ *		buffer and the set copies only the new ones.  Output is
+ *		buffered but flushed before each read, so a filter reading
+ *		from a pipe is never held back waiting for more input.  A
+ *		corpus file already lists its words in the order they first
+ *		appear, so only its dictionary is written, unless it is
+ *		truncated or corrupt, which sets CORRUPT.
+ */
+
+static void firstOccurrences(FILE *fp)
+{
+    static char output[1 << 16];
+    TOKENIZER *tp;
+    CORPUS *corpus;
+    SET *seen;
+    struct token tok;
+    int i;
+
+
+    setvbuf(stdout, output, _IOFBF, sizeof(output));
+    pool = createPool(0);
+
+    if (!lines && !normalize && !utf8 && delimiters == NULL && fp != stdin && (corpus = openCorpus(fp)) != NULL) {
+	corrupt = corpusError(corpus);
+
+	for (i = 0; i < numCorpusWords(corpus); i ++)
+	    printf("%s\n", corpusWord(corpus, i));
+
+	destroyCorpus(corpus);
+
+    } else {
+	seen = createSet(MAX_SIZE, strcmp, strhash);
+	setCopyFunction(seen, copyWord);
+	tp = openTokenizer(fp);
+	setTokenizerStreaming(tp, stdout);
+
+	while (nextToken(tp, &tok))
+	    if (addElement(seen, tok.text)) {
+		fwrite(tok.text, 1, tok.length, stdout);
+		putchar('\n');
+	    }
+
+	destroyTokenizer(tp);
+	destroySet(seen);
+    }
+
+    fclose(fp);
+    fflush(stdout);
+    destroyPool(pool);
+}
+
+
+/* A batch of query words waiting to be looked up, copied out of the
+   tokenizer's buffer, and how they are answered. */
+
+struct batch {
+    SET *dict;
+    char show;
+    char *text;
+    size_t size, used;
+    size_t offsets[QUERY_BATCH];
+    unsigned hashes[QUERY_BATCH];
+    int count;
+};
+
+
+/*
+ * Function:	answerQueries
+ *
+ * Description:	Look up the query words of the batch BP in its set and
+ *		print them with their answers, or only the hits or misses
+ *		if its SHOW is 'h' or 'm', and empty the batch.
+ */
+
+static void answerQueries(struct batch *bp)
+{
+    void *keys[QUERY_BATCH], *found[QUERY_BATCH];
+    int i;
+
+
+    for (i = 0; i < bp->count; i ++)
+	keys[i] = bp->text + bp->offsets[i];
+
+    findElementsByHash(bp->dict, keys, bp->hashes, bp->count, found);
+
+    for (i = 0; i < bp->count; i ++)
+	if (bp->show == 'a') {
+	    fputs(keys[i], stdout);
+	    fputs(found[i] != NULL ? ": hit\n" : ": miss\n", stdout);
+	} else if ((found[i] != NULL) == (bp->show == 'h')) {
+	    fputs(keys[i], stdout);
+	    putchar('\n');
+	}
+
+    bp->count = 0;
+    bp->used = 0;
+}
+
+
+/*
+ * Function:	queryWords
+ *
+ * Description:	Load the words of the file FP into a set, sized from a
+ *		sample if SFLAG is true, and answer whether each word of
+ *		the file QUERIES is in it, as answerQueries prints them.
+ *		Words are copied out of the tokenizer's buffer into a batch,
+ *		which is answered when it is full, and by the tokenizer
+ *		before every read so no answer waits on more input.
+ */
+
+static void queryWords(FILE *fp, FILE *queries, bool sflag, char show)
+{
+    static char output[1 << 16];
+    struct batch batch;
+    TOKENIZER *tp;
+    struct token tok;
+    int words;
+
+
+    setvbuf(stdout, output, _IOFBF, sizeof(output));
+    pool = createPool(0);
+    words = 0;
+    batch.dict = readWords(fp, sflag, &words);
+    fclose(fp);
+
+    if (batch.dict == NULL) {
+	fclose(queries);
+	destroyPool(pool);
+	return;
+    }
+
+    setLookupFunctions(batch.dict, strcmp, strhash);
+
+    batch.show = show;
+    batch.size = BUFSIZ;
+    batch.used = 0;
+    batch.count = 0;
+    batch.text = malloc(batch.size);
+
+    if (batch.text == NULL) {
+	fprintf(stderr, "out of memory\n");
+	exit(EXIT_FAILURE);
+    }
+
+    tp = openTokenizer(queries);
+    setTokenizerStreaming(tp, stdout);
+    setTokenizerBeforeRead(tp, answerQueries, &batch);
+
+    while (nextToken(tp, &tok)) {
+	if (batch.used + tok.length + 1 > batch.size) {
+	    while (batch.used + tok.length + 1 > batch.size)
+		batch.size *= 2;
+
+	    if ((batch.text = realloc(batch.text, batch.size)) == NULL) {
+		fprintf(stderr, "out of memory\n");
+		exit(EXIT_FAILURE);
+	    }
+	}
+
+	memcpy(batch.text + batch.used, tok.text, tok.length + 1);
+	batch.offsets[batch.count] = batch.used;
+	batch.hashes[batch.count ++] = tok.hash;
+	batch.used += tok.length + 1;
+
+	if (batch.count == QUERY_BATCH)
+	    answerQueries(&batch);
+    }
+
+    answerQueries(&batch);
+    destroyTokenizer(tp);
+    fclose(queries);
+    fflush(stdout);
+    free(batch.text);
+    destroySet(batch.dict);
+    destroyPool(pool);
+}
+
+
 /*
  * Function:    main
  *
@@ -52,25 +460,106 @@ static unsigned strhash(char *s)
 
 int main(int argc, char *argv[])
 {
-    FILE *fp;
-    char buffer[BUFSIZ], **elts, *word;
-    SET *unique;
-    int i, words;
-    bool lflag = false;
+    FILE *fp, *queries;
+    char **elts, op = 'd';
+    SET *unique, *other;
+    int i, words, threads = 1;
+    long megabytes = 0;
+    char *dictionary = NULL, show = 'a';
+    bool lflag = false, sflag = false, fflag = false;
 
 
     /* Check usage and open the first file. */
 
-    if (argc > 1 && strcmp(argv[1], "-l") == 0) {
-	lflag = true;
+    while (argc > 1 && argv[1][0] == '-' && argv[1][1] != '\0') {
+	if (strcmp(argv[1], "--lines") == 0)
+	    lines = true;
+	else if (strcmp(argv[1], "--normalize") == 0)
+	    normalize = true;
+	else if (strcmp(argv[1], "--utf8") == 0)
+	    utf8 = true;
+	else if (strncmp(argv[1], "--delim=", 8) == 0 && argv[1][8] != '\0')
+	    delimiters = argv[1] + 8;
+	else if (strcmp(argv[1], "--hits") == 0 || strcmp(argv[1], "--misses") == 0)
+	    show = argv[1][2];
+	else if (strcmp(argv[1], "--query") == 0) {
+	    if (argc < 3)
+		break;
+
+	    dictionary = argv[2];
+	    argc --;
+
+	    for (i = 1; i < argc; i ++)
+		argv[i] = argv[i + 1];
+	} else if (argv[1][2] != '\0' || strchr("lsuidtmfF", argv[1][1]) == NULL)
+	    break;
+	else if (argv[1][1] == 'l')
+	    lflag = true;
+	else if (argv[1][1] == 's')
+	    sflag = true;
+	else if (argv[1][1] == 'f' || argv[1][1] == 'F') {
+	    fflag = true;
+	    lines = lines || argv[1][1] == 'F';
+	} else if (argv[1][1] != 't' && argv[1][1] != 'm')
+	    op = argv[1][1];
+	else if (argc > 2 && argv[1][1] == 'm' && (megabytes = atol(argv[2])) > 0) {
+	    argc --;
+
+	    for (i = 1; i < argc; i ++)
+		argv[i] = argv[i + 1];
+	} else if (argc > 2 && argv[1][1] == 't' && (threads = atoi(argv[2])) > 0) {
+	    argc --;
+
+	    for (i = 1; i < argc; i ++)
+		argv[i] = argv[i + 1];
+	} else
+	    break;
+
 	argc --;
 
 	for (i = 1; i < argc; i ++)
 	    argv[i] = argv[i + 1];
     }
 
-    if (argc == 1 || argc > 3) {
-        fprintf(stderr, "usage: %s [-l] file1 [file2]\n", argv[0]);
+    if (fflag && argc <= 2) {
+	fp = argc == 1 || strcmp(argv[1], "-") == 0 ? stdin : fopen(argv[1], "r");
+
+	if (fp == NULL) {
+	    fprintf(stderr, "%s: cannot open %s\n", argv[0], argv[1]);
+	    exit(EXIT_FAILURE);
+	}
+
+	firstOccurrences(fp);
+
+	if (corrupt) {
+	    fprintf(stderr, "%s: corrupt corpus %s\n", argv[0], argv[1]);
+	    exit(EXIT_FAILURE);
+	}
+
+	exit(EXIT_SUCCESS);
+    }
+
+    if (dictionary != NULL && !fflag && megabytes == 0 && argc <= 2) {
+	if ((fp = fopen(dictionary, "r")) == NULL || (queries = argc == 1 || strcmp(argv[1], "-") == 0 ? stdin : fopen(argv[1], "r")) == NULL) {
+	    fprintf(stderr, "%s: cannot open %s\n", argv[0], fp == NULL ? dictionary : argv[1]);
+	    exit(EXIT_FAILURE);
+	}
+
+	queryWords(fp, queries, sflag, show);
+
+	if (corrupt) {
+	    fprintf(stderr, "%s: corrupt corpus %s\n", argv[0], dictionary);
+	    exit(EXIT_FAILURE);
+	}
+
+	exit(EXIT_SUCCESS);
+    }
+
+    if (fflag || dictionary != NULL || show != 'a' || argc == 1 || argv[1][0] == '-' || (megabytes > 0 && argc > 2)) {
+        fprintf(stderr, "usage: %s [-l] [-s] [-u | -i | -d] [-t threads] [--lines | --delim=chars] [--normalize] [--utf8] file1 [file2 ...]\n", argv[0]);
+        fprintf(stderr, "       %s -f | -F [--lines | --delim=chars] [--normalize] [--utf8] [file]\n", argv[0]);
+        fprintf(stderr, "       %s -m megabytes [-l] [--lines | --delim=chars] [--normalize] [--utf8] file\n", argv[0]);
+        fprintf(stderr, "       %s --query dictionary [--hits | --misses] [-s] [--lines | --delim=chars] [--normalize] [--utf8] [file]\n", argv[0]);
         exit(EXIT_FAILURE);
     }
 
@@ -80,18 +569,37 @@ int main(int argc, char *argv[])
     }
 
 
+    /* Count the words within the memory budget if one was given. */
+
+    if (megabytes > 0) {
+	if (!spillWords(fp, megabytes << 20, lflag)) {
+	    fprintf(stderr, "%s: cannot write temporary file\n", argv[0]);
+	    exit(EXIT_FAILURE);
+	}
+
+	if (corrupt) {
+	    fprintf(stderr, "%s: corrupt corpus %s\n", argv[0], argv[1]);
+	    exit(EXIT_FAILURE);
+	}
+
+	fclose(fp);
+	exit(EXIT_SUCCESS);
+    }
+
+
     /* Insert all words into the set. */
 
+    pool = createPool(0);
     words = 0;
-    unique = createSet(MAX_SIZE, strcmp, strhash);
+    unique = readWords(fp, sflag, &words);
+    fclose(fp);
 
-    while (fscanf(fp, "%s", buffer) == 1) {
-        words ++;
-	if (!findElement(unique, buffer))
-	    addElement(unique, strdup(buffer));
+    if (unique == NULL) {
+	fprintf(stderr, "%s: corrupt corpus %s\n", argv[0], argv[1]);
+	exit(EXIT_FAILURE);
     }
 
-    fclose(fp);
+    setThreads(unique, threads);
 
     if (!lflag) {
 	printf("%d total words\n", words);
@@ -99,28 +607,39 @@ int main(int argc, char *argv[])
     }
 
 
-    /* Try to open the second file. */
-
-    if (argc == 3) {
-        if ((fp = fopen(argv[2], "r")) == NULL) {
-            fprintf(stderr, "%s: cannot open %s\n", argv[0], argv[2]);
-            exit(EXIT_FAILURE);
-        }
+    /* Combine the words of each further file with the set. */
 
+    if (argc > 2) {
+	for (i = 2; i < argc; i ++) {
+	    if ((fp = fopen(argv[i], "r")) == NULL) {
+		fprintf(stderr, "%s: cannot open %s\n", argv[0], argv[i]);
+		exit(EXIT_FAILURE);
+	    }
 
-        /* Delete all words in the second file. */
+	    words = 0;
+	    other = readWords(fp, sflag, &words);
+	    fclose(fp);
 
-        while (fscanf(fp, "%s", buffer) == 1) {
-	    if ((word = findElement(unique, buffer)) != NULL) {
-		removeElement(unique, buffer);
-		free(word);
+	    if (other == NULL) {
+		fprintf(stderr, "%s: corrupt corpus %s\n", argv[0], argv[i]);
+		exit(EXIT_FAILURE);
 	    }
+
+	    if (op == 'u')
+		unionSets(unique, other, true);
+	    else if (op == 'i')
+		intersectSets(unique, other, true);
+	    else
+		differenceSets(unique, other, true);
+
+	    destroySet(other);
 	}
 
-	fclose(fp);
+	shrinkSet(unique);
 
 	if (!lflag)
-	    printf("%d remaining words\n", numElements(unique));
+	    printf("%d %s words\n", numElements(unique),
+		op == 'u' ? "combined" : op == 'i' ? "common" : "remaining");
     }
 
 
@@ -136,5 +655,6 @@ int main(int argc, char *argv[])
     }
 
     destroySet(unique);
+    destroyPool(pool);
     exit(EXIT_SUCCESS);
 }
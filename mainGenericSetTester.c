@@ -0,0 +1,232 @@
+/*
+ * File:        mainGenericSetTester.c
+ *
+ * Description: This file contains the main function for testing the
+ *              union, intersection, and difference of generic sets.
+ *
+ *              Pairs of sets of integers are built at random, with some
+ *              elements removed again so the tables hold deleted slots,
+ *              from sparse, dense, empty, disjoint, and identical pairs.
+ *              Each operation is done both in place and as a new set, by
+ *              one thread and by four, and the result is compared with
+ *              the answer found element by element.  The set that is not
+ *              changed must still hold what it held.
+ */
+
+# include <stdio.h>
+# include <stdlib.h>
+# include <stdint.h>
+# include <stdbool.h>
+# include "generic/set.h"
+
+
+# define UNIVERSE 60000
+# define NUM_PAIRS 7
+
+
+/* The elements, whose addresses are stored in the sets. */
+
+static int values[UNIVERSE];
+
+
+/* The names of the operations, in the order runOperation takes them. */
+
+static char *names[] = {"union", "intersection", "difference"};
+
+
+/*
+ * Function:    compareInts
+ *
+ * Description: Compare the integers at P1 and P2.
+ */
+
+static int compareInts(int *p1, int *p2) {
+
+    return *p1 < *p2 ? -1 : *p1 > *p2;
+}
+
+
+/*
+ * Function:    hashInt
+ *
+ * Description: Return a hash value for the integer at P.
+ */
+
+static unsigned hashInt(int *p) {
+
+    return *p * 2654435761u;
+}
+
+
+/*
+ * Function:    nextRandom
+ *
+ * Description: Return the next number from the xorshift generator whose
+ *              state is STATE.
+ */
+
+static uint32_t nextRandom(uint64_t *state) {
+
+    uint64_t x = *state;
+
+
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x >> 32;
+}
+
+
+/*
+ * Function:    buildSet
+ *
+ * Description: Return a new set of the elements marked in MEMBERS.  Some
+ *              other elements are added and removed again first.
+ */
+
+static SET *buildSet(bool *members, uint64_t *state) {
+
+    SET *sp;
+    int i;
+
+
+    sp = createSet(16, compareInts, hashInt);
+
+    for (i = 0; i < UNIVERSE; i++)
+        if (members[i] || nextRandom(state) % 8 == 0)
+            addElement(sp, &values[i]);
+
+    for (i = 0; i < UNIVERSE; i++)
+        if (!members[i])
+            removeElement(sp, &values[i]);
+
+    return sp;
+}
+
+
+/*
+ * Function:    matches
+ *
+ * Description: Return whether the set SP holds exactly the elements
+ *              marked in MEMBERS.
+ */
+
+static bool matches(SET *sp, bool *members) {
+
+    int i, n, count;
+    int **elts;
+    bool ok;
+
+
+    for (count = 0, i = 0; i < UNIVERSE; i++)
+        count += members[i];
+
+    n = numElements(sp);
+    ok = n == count;
+
+    for (i = 0; ok && i < UNIVERSE; i++)
+        if (members[i] && findElement(sp, &values[i]) != &values[i])
+            ok = false;
+
+    elts = getElements(sp);
+
+    for (i = 0; ok && i < n; i++)
+        if (!members[*elts[i]])
+            ok = false;
+
+    free(elts);
+    return ok;
+}
+
+
+/*
+ * Function:    runOperation
+ *
+ * Description: Do operation OP, 0 for union, 1 for intersection, and 2
+ *              for difference, on the sets of the elements marked in IN1
+ *              and IN2, in place if INPLACE is true, with THREADS threads.
+ *              Return whether the result and the sets are as expected.
+ */
+
+static bool runOperation(int op, bool *in1, bool *in2, bool inPlace, int threads, uint64_t *state) {
+
+    bool expected[UNIVERSE], ok;
+    SET *sp1, *sp2, *result;
+    int i;
+
+
+    for (i = 0; i < UNIVERSE; i++)
+        expected[i] = op == 0 ? in1[i] || in2[i] : op == 1 ? in1[i] && in2[i] : in1[i] && !in2[i];
+
+    sp1 = buildSet(in1, state);
+    sp2 = buildSet(in2, state);
+    setThreads(sp1, threads);
+
+    if (op == 0)
+        result = unionSets(sp1, sp2, inPlace);
+    else if (op == 1)
+        result = intersectSets(sp1, sp2, inPlace);
+    else
+        result = differenceSets(sp1, sp2, inPlace);
+
+    ok = (result == sp1) == inPlace && matches(result, expected) && matches(sp2, in2);
+
+    if (!inPlace) {
+        ok = ok && matches(sp1, in1);
+        destroySet(result);
+    }
+
+    destroySet(sp1);
+    destroySet(sp2);
+    return ok;
+}
+
+
+/*
+ * Function:    main
+ *
+ * Description: Driver function for the test application.
+ */
+
+int main(void) {
+
+    static bool in1[UNIVERSE], in2[UNIVERSE];
+    unsigned density1[NUM_PAIRS] = {50, 10, 90, 0, 50, 50, 50};
+    unsigned density2[NUM_PAIRS] = {50, 90, 10, 50, 0, 50, 50};
+    int i, op, pair, threads, inPlace, failed;
+    uint64_t state;
+
+
+    state = 88172645463325252ull;
+    failed = 0;
+
+    for (i = 0; i < UNIVERSE; i++)
+        values[i] = i;
+
+    /* The last two pairs are disjoint and identical. */
+
+    for (pair = 0; pair < NUM_PAIRS; pair++) {
+        for (i = 0; i < UNIVERSE; i++) {
+            in1[i] = nextRandom(&state) % 100 < density1[pair];
+            in2[i] = nextRandom(&state) % 100 < density2[pair];
+
+            if (pair == NUM_PAIRS - 2)
+                in2[i] = !in1[i] && in2[i];
+            else if (pair == NUM_PAIRS - 1)
+                in2[i] = in1[i];
+        }
+
+        for (op = 0; op < 3; op++)
+            for (threads = 1; threads <= 4; threads += 3)
+                for (inPlace = 0; inPlace <= 1; inPlace++)
+                    if (!runOperation(op, in1, in2, inPlace, threads, &state)) {
+                        printf("pair %d: %s %s with %d threads is wrong\n",
+                            pair, inPlace ? "in-place" : "new", names[op], threads);
+                        failed++;
+                    }
+    }
+
+    printf("generic set operations: %s\n", failed > 0 ? "FAILED" : "ok");
+    exit(failed > 0 ? EXIT_FAILURE : EXIT_SUCCESS);
+}
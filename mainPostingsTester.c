@@ -0,0 +1,152 @@
+/*
+ * File:        mainPostingsTester.c
+ *
+ * Description: This file contains the main function for testing the
+ *              compressed posting list.
+ *
+ *              For every bit width from 0 to 32, posting lists whose
+ *              blocks are packed at that width are built from random
+ *              differences, with the widest difference moved through
+ *              every slot of a block and partial blocks of every length.
+ *              Each list is decoded and compared with the positions that
+ *              were added.  A checksum of the encoded bytes is printed
+ *              for each width, so the output of a build with SSE2 and a
+ *              build without it can be compared to show that both write
+ *              the same bytes.
+ */
+
+# include <stdio.h>
+# include <stdlib.h>
+# include <stdint.h>
+# include "generic/postings.h"
+
+
+# define BLOCK_SIZE 128
+# define MAX_WIDTH 32
+# define MAX_BLOCKS 4
+# define NARROW_WIDTH 22
+
+
+/*
+ * Function:    nextRandom
+ *
+ * Description: Return the next number from the xorshift generator whose
+ *              state is STATE.
+ */
+
+static uint32_t nextRandom(uint64_t *state) {
+
+    uint64_t x = *state;
+
+
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x >> 32;
+}
+
+
+/*
+ * Function:    lowBits
+ *
+ * Description: Return a mask of the low B bits.
+ */
+
+static uint32_t lowBits(int b) {
+
+    return b < 32 ? (1u << b) - 1 : UINT32_MAX;
+}
+
+
+/*
+ * Function:    testList
+ *
+ * Description: Build a posting list of N positions whose full blocks are
+ *              packed at width B, with the widest difference of each
+ *              block at slot WIDE, and check that it decodes to the same
+ *              positions.  Return false if it does not, and add the
+ *              encoded bytes to the checksum at SUM.
+ */
+
+static int testList(int b, int n, int wide, uint64_t *state, uint32_t *sum) {
+
+    uint32_t *positions, *decoded, position, delta, narrow;
+    const unsigned char *bytes;
+    POSTINGS *pp;
+    size_t length, j;
+    int i, ok;
+
+
+    /* The other differences are kept narrow enough that the positions
+       never pass 2 to the 32nd, even at width 32. */
+
+    narrow = lowBits(b < NARROW_WIDTH ? b : NARROW_WIDTH);
+    positions = malloc(n * sizeof(uint32_t));
+    pp = createPostings();
+    position = 0;
+
+    for (i = 0; i < n; i++) {
+        if (i / BLOCK_SIZE == n / BLOCK_SIZE)
+            delta = nextRandom(state) & 0xFFFF;
+        else if (i % BLOCK_SIZE == wide && b > 0)
+            delta = 1u << (b - 1) | (nextRandom(state) & lowBits(b - 1) & lowBits(30));
+        else
+            delta = nextRandom(state) & narrow;
+
+        position += delta;
+        positions[i] = position;
+        addPosting(pp, position);
+    }
+
+    bytes = finishPostings(pp, &length);
+    decoded = decodePostings(bytes, length, n);
+    ok = 1;
+
+    for (i = 0; i < n; i++)
+        if (decoded[i] != positions[i])
+            ok = 0;
+
+    for (j = 0; j < length; j++)
+        *sum = (*sum ^ bytes[j]) * 16777619u;
+
+    free(decoded);
+    free(positions);
+    destroyPostings(pp);
+    return ok;
+}
+
+
+/*
+ * Function:    main
+ *
+ * Description: Driver function for the test application.
+ */
+
+int main(void) {
+
+    uint64_t state;
+    uint32_t sum;
+    int b, i, n, failed;
+
+
+    state = 88172645463325252ull;
+    failed = 0;
+
+    for (b = 0; b <= MAX_WIDTH; b++) {
+        sum = 2166136261u;
+
+        for (i = 0; i < BLOCK_SIZE; i++) {
+            n = (b <= NARROW_WIDTH ? MAX_BLOCKS : 1) * BLOCK_SIZE + i;
+
+            if (!testList(b, n, i, &state, &sum)) {
+                printf("width %d: list of %d positions does not round trip\n", b, n);
+                failed++;
+            }
+        }
+
+        printf("width %2d: %d lists, checksum %08x\n", b, BLOCK_SIZE, sum);
+    }
+
+    exit(failed > 0 ? EXIT_FAILURE : EXIT_SUCCESS);
+}
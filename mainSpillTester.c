@@ -0,0 +1,186 @@
+/*
+ * File:        mainSpillTester.c
+ *
+ * Description: This file contains the main function for testing the
+ *              counting of words within a memory budget.
+ *
+ *              A vocabulary of words with long shared prefixes, plus one
+ *              word longer than the buffers runs are read through, is
+ *              counted with random counts under budgets from sixteen
+ *              kilobytes, which spill many runs, up to one large enough
+ *              that nothing is spilled.  The words that come back must be
+ *              in strcmp() order, each once, with the same total count as
+ *              was kept in memory for it.  The test runs with only
+ *              MAX_FILES files allowed open, far fewer than the number of
+ *              runs the small budgets write.
+ */
+
+# include <stdio.h>
+# include <stdlib.h>
+# include <string.h>
+# include <stdint.h>
+# include <sys/resource.h>
+# include "generic/spill.h"
+
+
+# define NUM_WORDS 20000
+# define NUM_ADDS 200000
+# define MAX_PREFIX 20
+# define LONG_WORD 100000
+# define MAX_FILES 40
+
+
+/*
+ * Function:    nextRandom
+ *
+ * Description: Return the next number from the xorshift generator whose
+ *              state is STATE.
+ */
+
+static uint32_t nextRandom(uint64_t *state) {
+
+    uint64_t x = *state;
+
+
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x >> 32;
+}
+
+
+/*
+ * Function:    makeWords
+ *
+ * Description: Return an array of N distinct words.  Each is a run of
+ *              up to MAX_PREFIX letters from a small alphabet, so many
+ *              share their first eight bytes, then a period and its
+ *              index.  The last word is much longer.
+ */
+
+static char **makeWords(int n, uint64_t *state) {
+
+    char **words, buffer[MAX_PREFIX + 16];
+    int i, j, length;
+
+
+    words = malloc(n * sizeof(char *));
+
+    for (i = 0; i < n - 1; i++) {
+        length = nextRandom(state) % (MAX_PREFIX + 1);
+
+        for (j = 0; j < length; j++)
+            buffer[j] = 'a' + nextRandom(state) % 3;
+
+        sprintf(buffer + length, ".%d", i);
+        words[i] = strdup(buffer);
+    }
+
+    words[i] = malloc(LONG_WORD + 16);
+    memset(words[i], 'b', LONG_WORD);
+    sprintf(words[i] + LONG_WORD, ".%d", i);
+    return words;
+}
+
+
+/*
+ * Function:    testBudget
+ *
+ * Description: Count NUM_ADDS random words of the N WORDS within BUDGET
+ *              bytes and check the merged counts against COUNTS.  Return
+ *              the number of runs spilled, or -1 if the check fails.
+ */
+
+static int testBudget(char **words, int n, size_t budget, uint64_t *state) {
+
+    long *counts, count;
+    char *word, *last, *dot;
+    int i, k, runs, ok, distinct;
+    SPILL *sp;
+
+
+    counts = calloc(n, sizeof(long));
+    sp = createSpill(budget);
+
+    for (i = 0; i < NUM_ADDS; i++) {
+        k = nextRandom(state) % n;
+
+        if (k % 2 == 0)
+            k = k / 16;
+
+        count = 1 + nextRandom(state) % 3;
+        counts[k] += count;
+        addToSpill(sp, words[k], count);
+    }
+
+    ok = finishSpill(sp);
+    runs = numRuns(sp);
+    last = NULL;
+    distinct = 0;
+
+    while (ok && nextSpilled(sp, &word, &count)) {
+        dot = strrchr(word, '.');
+        k = dot != NULL ? atoi(dot + 1) : -1;
+
+        if (k < 0 || k >= n || strcmp(word, words[k]) != 0 || counts[k] != count)
+            ok = 0;
+        else if (last != NULL && strcmp(last, word) >= 0)
+            ok = 0;
+        else {
+            counts[k] = 0;
+            distinct++;
+        }
+
+        free(last);
+        last = strdup(word);
+    }
+
+    for (i = 0; i < n; i++)
+        if (counts[i] != 0)
+            ok = 0;
+
+    printf("budget %8lu: %4d runs, %d distinct words%s\n", (unsigned long) budget, runs, distinct, ok ? "" : ", FAILED");
+
+    free(last);
+    free(counts);
+    destroySpill(sp);
+    return ok ? runs : -1;
+}
+
+
+/*
+ * Function:    main
+ *
+ * Description: Driver function for the test application.
+ */
+
+int main(void) {
+
+    size_t budgets[] = {16384, 65536, 262144, 1 << 30};
+    struct rlimit limit;
+    uint64_t state;
+    char **words;
+    int i, runs, failed;
+
+
+    limit.rlim_cur = limit.rlim_max = MAX_FILES;
+    setrlimit(RLIMIT_NOFILE, &limit);
+
+    state = 88172645463325252ull;
+    words = makeWords(NUM_WORDS, &state);
+    failed = 0;
+
+    for (i = 0; i < sizeof(budgets) / sizeof(budgets[0]); i++) {
+        runs = testBudget(words, NUM_WORDS, budgets[i], &state);
+
+        if (runs < 0 || (budgets[i] < (1 << 30) && runs < 2) || (budgets[i] == 1 << 30 && runs > 0))
+            failed++;
+    }
+
+    for (i = 0; i < NUM_WORDS; i++)
+        free(words[i]);
+
+    free(words);
+    exit(failed > 0 ? EXIT_FAILURE : EXIT_SUCCESS);
+}
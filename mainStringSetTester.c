@@ -0,0 +1,403 @@
+/*
+ * File:        mainStringSetTester.c
+ *
+ * Description: This file contains the main function for testing the set
+ *              abstract data type for strings.
+ *
+ *              Pairs of sets of words are built at random, with some
+ *              words removed again, and their union, intersection, and
+ *              difference are done both in place and as a new set, by one
+ *              thread and by four, and compared with the answer found word
+ *              by word.
+ *
+ *              A set with a capacity is put through adds, finds and
+ *              removes with automatic shrinking on, explicit shrinking,
+ *              and an in-place union with a much larger set.  After each
+ *              step it must hold no more than its capacity, and the
+ *              memory it has allocated must stay within what its fixed
+ *              table of twice the capacity and its strings need.
+ */
+
+# include <stdio.h>
+# include <stdlib.h>
+# include <string.h>
+# include <stdint.h>
+# include <stdbool.h>
+# include "strings/set.h"
+
+
+# define CAPACITY 1000
+# define NUM_WORDS 200000
+# define NUM_STEPS 400000
+# define WORD_SIZE 11
+# define UNIVERSE 20000
+# define NUM_PAIRS 7
+
+
+/* The bytes the sets being tested have allocated and not released, and
+   the bytes of an empty set, which hold the set itself. */
+
+static long live, empty;
+
+
+/* The names of the operations, in the order runOperation takes them. */
+
+static char *names[] = {"union", "intersection", "difference"};
+
+
+/*
+ * Function:    countAllocate
+ *
+ * Description: Allocate SIZE bytes and count them as live.
+ */
+
+static void *countAllocate(size_t size, void *context) {
+
+    live += size;
+    return malloc(size);
+}
+
+
+/*
+ * Function:    countRelease
+ *
+ * Description: Free PTR of SIZE bytes and stop counting them.
+ */
+
+static void countRelease(void *ptr, size_t size, void *context) {
+
+    live -= size;
+    free(ptr);
+}
+
+
+static const struct set_allocator counter = {countAllocate, countRelease, NULL};
+
+
+/*
+ * Function:    nextRandom
+ *
+ * Description: Return the next number from the xorshift generator whose
+ *              state is STATE.
+ */
+
+static uint32_t nextRandom(uint64_t *state) {
+
+    uint64_t x = *state;
+
+
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x >> 32;
+}
+
+
+/*
+ * Function:    makeWord
+ *
+ * Description: Write the word numbered N into BUFFER and return it.  Every
+ *              word takes WORD_SIZE bytes with its null character.
+ */
+
+static char *makeWord(char *buffer, int n) {
+
+    sprintf(buffer, "word%06d", n);
+    return buffer;
+}
+
+
+/*
+ * Function:    buildSet
+ *
+ * Description: Return a new set of the words marked in MEMBERS.  Some
+ *              other words are added and removed again first.
+ */
+
+static SET *buildSet(bool *members, uint64_t *state) {
+
+    char buffer[WORD_SIZE + 1];
+    SET *sp;
+    int i;
+
+
+    sp = createSet(16);
+
+    for (i = 0; i < UNIVERSE; i++)
+        if (members[i] || nextRandom(state) % 8 == 0)
+            addElement(sp, makeWord(buffer, i));
+
+    for (i = 0; i < UNIVERSE; i++)
+        if (!members[i])
+            removeElement(sp, makeWord(buffer, i));
+
+    return sp;
+}
+
+
+/*
+ * Function:    matches
+ *
+ * Description: Return whether the set SP holds exactly the words marked in
+ *              MEMBERS.
+ */
+
+static bool matches(SET *sp, bool *members) {
+
+    char buffer[WORD_SIZE + 1], **elts;
+    int i, n, count;
+    bool ok;
+
+
+    for (count = 0, i = 0; i < UNIVERSE; i++)
+        count += members[i];
+
+    n = numElements(sp);
+    ok = n == count;
+
+    for (i = 0; ok && i < UNIVERSE; i++)
+        if (members[i] && findElement(sp, makeWord(buffer, i)) == NULL)
+            ok = false;
+
+    elts = getElements(sp);
+
+    for (i = 0; i < n; i++) {
+        if (ok && !members[atoi(elts[i] + 4)])
+            ok = false;
+
+        free(elts[i]);
+    }
+
+    free(elts);
+    return ok;
+}
+
+
+/*
+ * Function:    runOperation
+ *
+ * Description: Do operation OP, 0 for union, 1 for intersection, and 2
+ *              for difference, on the sets of the words marked in IN1 and
+ *              IN2, in place if INPLACE is true, with THREADS threads.
+ *              Return whether the result and the sets are as expected.
+ */
+
+static bool runOperation(int op, bool *in1, bool *in2, bool inPlace, int threads, uint64_t *state) {
+
+    bool expected[UNIVERSE], ok;
+    SET *sp1, *sp2, *result;
+    int i;
+
+
+    for (i = 0; i < UNIVERSE; i++)
+        expected[i] = op == 0 ? in1[i] || in2[i] : op == 1 ? in1[i] && in2[i] : in1[i] && !in2[i];
+
+    sp1 = buildSet(in1, state);
+    sp2 = buildSet(in2, state);
+    setThreads(sp1, threads);
+
+    if (op == 0)
+        result = unionSets(sp1, sp2, inPlace);
+    else if (op == 1)
+        result = intersectSets(sp1, sp2, inPlace);
+    else
+        result = differenceSets(sp1, sp2, inPlace);
+
+    ok = (result == sp1) == inPlace && matches(result, expected) && matches(sp2, in2);
+
+    if (!inPlace) {
+        ok = ok && matches(sp1, in1);
+        destroySet(result);
+    }
+
+    destroySet(sp1);
+    destroySet(sp2);
+    return ok;
+}
+
+
+/*
+ * Function:    testOperations
+ *
+ * Description: Check the union, intersection, and difference of pairs of
+ *              sets of every density, and return the number that are
+ *              wrong.
+ */
+
+static int testOperations(uint64_t *state) {
+
+    static bool in1[UNIVERSE], in2[UNIVERSE];
+    unsigned density1[NUM_PAIRS] = {50, 10, 90, 0, 50, 50, 50};
+    unsigned density2[NUM_PAIRS] = {50, 90, 10, 50, 0, 50, 50};
+    int i, op, pair, threads, inPlace, failed;
+
+
+    failed = 0;
+
+    /* The last two pairs are disjoint and identical. */
+
+    for (pair = 0; pair < NUM_PAIRS; pair++) {
+        for (i = 0; i < UNIVERSE; i++) {
+            in1[i] = nextRandom(state) % 100 < density1[pair];
+            in2[i] = nextRandom(state) % 100 < density2[pair];
+
+            if (pair == NUM_PAIRS - 2)
+                in2[i] = !in1[i] && in2[i];
+            else if (pair == NUM_PAIRS - 1)
+                in2[i] = in1[i];
+        }
+
+        for (op = 0; op < 3; op++)
+            for (threads = 1; threads <= 4; threads += 3)
+                for (inPlace = 0; inPlace <= 1; inPlace++)
+                    if (!runOperation(op, in1, in2, inPlace, threads, state)) {
+                        printf("pair %d: %s %s with %d threads is wrong\n",
+                            pair, inPlace ? "in-place" : "new", names[op], threads);
+                        failed++;
+                    }
+    }
+
+    printf("string set operations: %s\n", failed > 0 ? "FAILED" : "ok");
+    return failed;
+}
+
+
+/*
+ * Function:    checkCapped
+ *
+ * Description: Return whether the set SP with a capacity of CAPACITY
+ *              holds no more than it, and has allocated no more than an
+ *              empty set, its table of twice the capacity, its referenced
+ *              bits, and the strings it holds need.  STEP says what was just done to it.
+ */
+
+static int checkCapped(SET *sp, int capacity, char *step) {
+
+    long slots, limit;
+
+
+    slots = 2 * (capacity + 1);
+    limit = empty + slots * (sizeof(char *) + 1) + (slots + 63) / 64 * 8 + (long) numElements(sp) * WORD_SIZE;
+
+    if (numElements(sp) <= capacity && live <= limit)
+        return 1;
+
+    printf("capped set after %s: %d elements, %ld bytes, limit %d elements, %ld bytes\n",
+        step, numElements(sp), live, capacity, limit);
+    return 0;
+}
+
+
+/*
+ * Function:    testCapacity
+ *
+ * Description: Put a set with a capacity through adds, finds, removes,
+ *              shrinking and an in-place union, checking it after each,
+ *              and return the number of failed checks.
+ */
+
+static int testCapacity(uint64_t *state) {
+
+    char buffer[WORD_SIZE + 1], **elts;
+    SET *sp, *large;
+    int i, j, n, failed;
+
+
+    sp = createSetWithAllocator(0, &counter);
+    empty = live;
+    setCapacity(sp, CAPACITY);
+    setAutoShrink(sp, true);
+    failed = 0;
+
+
+    /* Churn through a vocabulary much larger than the capacity, and now
+       and then empty the set, so that it would shrink if it could, and
+       fill it again. */
+
+    for (i = 0; i < NUM_STEPS; i++) {
+        if (i % 50000 == 49999) {
+            n = numElements(sp);
+            elts = getElements(sp);
+
+            for (j = 0; j < n; j++) {
+                removeElement(sp, elts[j]);
+                free(elts[j]);
+            }
+
+            free(elts);
+
+            if (!checkCapped(sp, CAPACITY, "emptying"))
+                failed++;
+
+            continue;
+        }
+
+        makeWord(buffer, nextRandom(state) % NUM_WORDS);
+        n = nextRandom(state) % 4;
+
+        if (n == 0)
+            removeElement(sp, buffer);
+        else if (n == 1)
+            findElement(sp, buffer);
+        else
+            addElement(sp, buffer);
+
+        if (i % 1000 == 0 && !checkCapped(sp, CAPACITY, "churn"))
+            failed++;
+    }
+
+    shrinkSet(sp);
+
+    if (!checkCapped(sp, CAPACITY, "shrinkSet"))
+        failed++;
+
+
+    /* Union a much larger set into it, in place. */
+
+    large = createSet(16);
+
+    for (i = 0; i < NUM_WORDS; i++)
+        addElement(large, makeWord(buffer, i));
+
+    unionSets(sp, large, true);
+
+    if (!checkCapped(sp, CAPACITY, "unionSets") || numElements(sp) != CAPACITY)
+        failed++;
+
+    for (i = 0; i < NUM_STEPS / 4; i++)
+        addElement(sp, makeWord(buffer, NUM_WORDS + i));
+
+    if (!checkCapped(sp, CAPACITY, "adds after unionSets"))
+        failed++;
+
+    destroySet(large);
+    destroySet(sp);
+
+    if (live != 0) {
+        printf("capped set: %ld bytes not released\n", live);
+        failed++;
+    }
+
+    printf("capped set of %d: %s\n", CAPACITY, failed > 0 ? "FAILED" : "ok");
+    return failed;
+}
+
+
+/*
+ * Function:    main
+ *
+ * Description: Driver function for the test application.
+ */
+
+int main(void) {
+
+    uint64_t state;
+    int failed;
+
+
+    state = 88172645463325252ull;
+    failed = testOperations(&state);
+    failed += testCapacity(&state);
+    exit(failed > 0 ? EXIT_FAILURE : EXIT_SUCCESS);
+}
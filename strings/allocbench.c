@@ -0,0 +1,187 @@
+/*
+ * File:        allocbench.c
+ *
+ * Description: This file contains the main function for comparing a set
+ *              whose allocations go through libc malloc against one whose
+ *              allocations come from a bump allocator.
+ *
+ *              The program takes an optional number of words as a command
+ *              line argument.  That many distinct words are inserted into
+ *              each set and the set is destroyed, and the time taken for
+ *              each phase is printed.
+ */
+
+# include <stdio.h>
+# include <stdlib.h>
+# include <string.h>
+# include <time.h>
+# include "set.h"
+
+
+# define DEFAULT_WORDS 1000000
+# define BLOCK_SIZE (1 << 20)
+
+
+/* A bump allocator hands out memory from large blocks and frees nothing
+   until the whole region is freed at once. */
+
+struct block {
+    struct block *next;
+    size_t used, size;
+    char data[];
+};
+
+struct region {
+    struct block *head;
+};
+
+
+/*
+ * Function:    bumpAllocate
+ *
+ * Description: Return SIZE bytes from the current block of the region,
+ *              starting a new block if the current one is full.
+ */
+
+static void *bumpAllocate(size_t size, void *context)
+{
+    struct region *rp = context;
+    struct block *bp = rp->head;
+    size_t need;
+    void *ptr;
+
+
+    size = (size + 15) & ~(size_t) 15;
+
+    if (bp == NULL || bp->used + size > bp->size) {
+	need = size > BLOCK_SIZE ? size : BLOCK_SIZE;
+	bp = malloc(sizeof(struct block) + need);
+
+	if (bp == NULL)
+	    return NULL;
+
+	bp->next = rp->head;
+	bp->used = 0;
+	bp->size = need;
+	rp->head = bp;
+    }
+
+    ptr = bp->data + bp->used;
+    bp->used += size;
+    return ptr;
+}
+
+
+/*
+ * Function:    freeRegion
+ *
+ * Description: Free every block of the region at once.
+ */
+
+static void freeRegion(struct region *rp)
+{
+    struct block *bp, *next;
+
+
+    for (bp = rp->head; bp != NULL; bp = next) {
+	next = bp->next;
+	free(bp);
+    }
+
+    rp->head = NULL;
+}
+
+
+/*
+ * Function:    seconds
+ *
+ * Description: Return the current time in seconds.
+ */
+
+static double seconds(void)
+{
+    struct timespec ts;
+
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+/*
+ * Function:    run
+ *
+ * Description: Insert N words into SP, destroy it, and print the times
+ *              taken, labelled with NAME.  REGION is freed as part of the
+ *              teardown if it is not null.
+ */
+
+static void run(char *name, SET *sp, char **words, int n, struct region *region)
+{
+    double start, insert;
+    int i;
+
+
+    start = seconds();
+
+    for (i = 0; i < n; i ++)
+	addElement(sp, words[i]);
+
+    insert = seconds() - start;
+    start = seconds();
+    destroySet(sp);
+
+    if (region != NULL)
+	freeRegion(region);
+
+    printf("%-8s insert: %.3f s  teardown: %.3f s\n", name, insert, seconds() - start);
+}
+
+
+/*
+ * Function:    main
+ *
+ * Description: Driver function for the benchmark.
+ */
+
+int main(int argc, char *argv[])
+{
+    struct set_allocator bump;
+    struct region region;
+    char **words, buffer[32];
+    int i, n;
+
+
+    n = argc > 1 ? atoi(argv[1]) : DEFAULT_WORDS;
+
+    if (argc > 2 || n <= 0) {
+        fprintf(stderr, "usage: %s [words]\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    words = malloc(n * sizeof(char *));
+
+    if (words == NULL) {
+        fprintf(stderr, "%s: out of memory\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    for (i = 0; i < n; i ++) {
+	sprintf(buffer, "word%x", (unsigned) i * 2654435761u);
+	words[i] = strdup(buffer);
+    }
+
+    run("malloc", createSet(n * 4 / 3 + 1), words, n, NULL);
+
+    region.head = NULL;
+    bump.allocate = bumpAllocate;
+    bump.release = NULL;
+    bump.context = &region;
+    run("bump", createSetWithAllocator(n * 4 / 3 + 1, &bump), words, n, &region);
+
+    for (i = 0; i < n; i ++)
+	free(words[i]);
+
+    free(words);
+    exit(EXIT_SUCCESS);
+}
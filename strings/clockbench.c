@@ -0,0 +1,204 @@
+/*
+ * File:        clockbench.c
+ *
+ * Description: This file contains the main function for measuring a set
+ *              with a capacity, which evicts with CLOCK, on a stream of
+ *              words drawn from a Zipf distribution.
+ *
+ *              The program takes an optional number of words in the stream
+ *              and an optional number of distinct words to draw them from
+ *              as command line arguments.  For each skew, every word of
+ *              the stream is added to a set with no capacity and to sets
+ *              holding a fraction of the distinct words, and the hit rate
+ *              (the fraction of words already in the set) and throughput
+ *              of each set are printed.
+ */
+
+# include <stdio.h>
+# include <stdlib.h>
+# include <string.h>
+# include <math.h>
+# include <time.h>
+# include <stdint.h>
+# include "set.h"
+
+
+# define DEFAULT_STREAM 4000000
+# define DEFAULT_UNIVERSE 1000000
+
+
+/* The skews of the Zipf distributions, and the capacities of the sets as
+   a fraction of the distinct words, with 0 meaning no capacity. */
+
+static double skews[] = {0.8, 0.99, 1.2};
+
+static double fractions[] = {0, 0.01, 0.1, 0.25};
+
+
+/*
+ * Function:    seconds
+ *
+ * Description: Return the current time in seconds.
+ */
+
+static double seconds(void)
+{
+    struct timespec ts;
+
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+/*
+ * Function:    nextRandom
+ *
+ * Description: Return the next number from the xorshift generator whose
+ *              state is STATE.
+ */
+
+static uint64_t nextRandom(uint64_t *state)
+{
+    uint64_t x = *state;
+
+
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+
+/*
+ * Function:    makeStream
+ *
+ * Description: Fill STREAM with N ranks from 0 to U - 1 drawn from a
+ *              Zipf distribution with skew S, so rank I is drawn in
+ *              proportion to 1 / (I + 1)^S.
+ */
+
+static void makeStream(int *stream, int n, int u, double s)
+{
+    double *cdf, total, x;
+    uint64_t state = 88172645463325252ull;
+    int i, lo, hi, mid;
+
+
+    cdf = malloc(u * sizeof(double));
+
+    if (cdf == NULL) {
+	fprintf(stderr, "out of memory\n");
+	exit(EXIT_FAILURE);
+    }
+
+    for (total = 0, i = 0; i < u; i ++)
+	cdf[i] = total += pow(i + 1, -s);
+
+    for (i = 0; i < n; i ++) {
+	x = (nextRandom(&state) >> 11) * 0x1.0p-53 * total;
+
+	for (lo = 0, hi = u - 1; lo < hi; ) {
+	    mid = (lo + hi) / 2;
+
+	    if (cdf[mid] <= x)
+		lo = mid + 1;
+	    else
+		hi = mid;
+	}
+
+	stream[i] = lo;
+    }
+
+    free(cdf);
+}
+
+
+/*
+ * Function:    run
+ *
+ * Description: Add the words of each rank in STREAM to a new set with
+ *              a capacity of CAPACITY, or none if it is zero, and print
+ *              its hit rate and throughput.
+ */
+
+static void run(char **words, int *stream, int n, int capacity)
+{
+    double start, elapsed;
+    int i, hits;
+    SET *sp;
+
+
+    sp = createSet(capacity > 0 ? 2 * (capacity + 1) : 16);
+
+    if (capacity > 0)
+	setCapacity(sp, capacity);
+
+    hits = 0;
+    start = seconds();
+
+    for (i = 0; i < n; i ++)
+	hits += !addElement(sp, words[stream[i]]);
+
+    elapsed = seconds() - start;
+
+    if (capacity > 0)
+	printf("  capacity %-8d", capacity);
+    else
+	printf("  %-17s", "no capacity");
+
+    printf("  hit rate %6.2f%%  %6.1f M adds/s  %d elements\n",
+	100.0 * hits / n, n / elapsed / 1e6, numElements(sp));
+
+    destroySet(sp);
+}
+
+
+/*
+ * Function:    main
+ *
+ * Description: Driver function for the benchmark.
+ */
+
+int main(int argc, char *argv[])
+{
+    char **words, buffer[32];
+    int *stream, i, j, n, u;
+
+
+    n = argc > 1 ? atoi(argv[1]) : DEFAULT_STREAM;
+    u = argc > 2 ? atoi(argv[2]) : DEFAULT_UNIVERSE;
+
+    if (argc > 3 || n <= 0 || u <= 0) {
+        fprintf(stderr, "usage: %s [stream [distinct]]\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    words = malloc(u * sizeof(char *));
+    stream = malloc(n * sizeof(int));
+
+    if (words == NULL || stream == NULL) {
+        fprintf(stderr, "%s: out of memory\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    for (i = 0; i < u; i ++) {
+	sprintf(buffer, "word%x", (unsigned) i * 2654435761u);
+	words[i] = strdup(buffer);
+    }
+
+    for (i = 0; i < sizeof(skews) / sizeof(skews[0]); i ++) {
+	makeStream(stream, n, u, skews[i]);
+	printf("zipf %.2f, %d words, %d distinct\n", skews[i], n, u);
+
+	for (j = 0; j < sizeof(fractions) / sizeof(fractions[0]); j ++)
+	    run(words, stream, n, fractions[j] * u);
+    }
+
+    for (i = 0; i < u; i ++)
+	free(words[i]);
+
+    free(words);
+    free(stream);
+    exit(EXIT_SUCCESS);
+}
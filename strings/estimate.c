@@ -0,0 +1,148 @@
+//estimate.c
+/**
+ * This file (estimate.c) estimates how many distinct words a file contains so a set can be created at the right size.
+ * A few regions spread evenly through the file are read and their words are counted with a small HyperLogLog sketch.
+ * The count for the sample is then extrapolated to the whole file with Heaps' law,
+ * which says the number of distinct words grows with about the square root of the length of a text.
+ *
+ * @author Max Blennemann
+ * @version 10/18/26
+ */
+
+#include "estimate.h"
+#include <stdlib.h>
+#include <stdint.h>
+#include <assert.h>
+#include <ctype.h>
+#include <math.h>
+#define REGIONS 8 // Number of regions read from a large file
+#define REGION_SIZE 65536 // Number of bytes read from each region
+#define BITS 10 // log2 of the number of registers in the sketch
+#define REGISTERS (1 << BITS)
+#define HEAPS_BETA 0.5 // Exponent of Heaps' law for English text
+
+/**
+ * Returns a 64-bit hash value for the given word.
+ * The word is hashed with FNV-1a and then mixed with the MurmurHash3 finalizer so every bit is usable by the sketch.
+ *
+ * @param s the first character of the word
+ * @param n the length of the word
+ * @return the hash value
+ * @timeComplexity O(N)
+ */
+static uint64_t wordHash(const char* s, size_t n) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    size_t i = 0;
+    for (; i < n; i++)
+        hash = (hash ^ (unsigned char) s[i]) * 0x100000001b3ULL;
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+/**
+ * Adds every whitespace separated word in a buffer to the sketch.
+ * If the buffer starts partway through the file, the partial word at the start is skipped.
+ * The partial word at the end is always skipped unless the buffer reaches the end of the file.
+ *
+ * @param registers the sketch to add to
+ * @param buffer the bytes read from the file
+ * @param n the number of bytes in the buffer
+ * @param atStart whether the buffer starts at the start of the file
+ * @param atEnd whether the buffer ends at the end of the file
+ * @timeComplexity O(n)
+ */
+static void addWords(unsigned char* registers, const char* buffer, size_t n, int atStart, int atEnd) {
+    size_t i = 0;
+    if (!atStart)
+        while (i < n && !isspace((unsigned char) buffer[i]))
+            i++;
+    while (i < n) {
+        while (i < n && isspace((unsigned char) buffer[i]))
+            i++;
+        size_t start = i;
+        while (i < n && !isspace((unsigned char) buffer[i]))
+            i++;
+        if (i == start || (i == n && !atEnd))
+            break;
+        uint64_t hash = wordHash(buffer + start, i - start);
+        unsigned index = hash >> (64 - BITS);
+        uint64_t rest = hash << BITS;
+        unsigned char rank = rest == 0 ? 64 - BITS + 1 : __builtin_clzll(rest) + 1;
+        if (rank > registers[index])
+            registers[index] = rank;
+    }
+}
+
+/**
+ * Returns the number of distinct values the sketch has seen.
+ * Uses linear counting when the sketch is mostly empty, as HyperLogLog is biased for small counts.
+ *
+ * @param registers the sketch to read
+ * @return the estimated number of distinct values
+ * @timeComplexity O(1)
+ */
+static double countSketch(const unsigned char* registers) {
+    double sum = 0;
+    int zeros = 0;
+    int i = 0;
+    for (; i < REGISTERS; i++) {
+        sum += ldexp(1.0, -registers[i]);
+        zeros += registers[i] == 0;
+    }
+    double estimate = 0.7213 / (1 + 1.079 / REGISTERS) * REGISTERS * REGISTERS / sum;
+    if (estimate <= 2.5 * REGISTERS && zeros > 0)
+        estimate = REGISTERS * log((double) REGISTERS / zeros);
+    return estimate;
+}
+
+/**
+ * Estimates the number of distinct words in a file by sampling it.
+ * Small files are read completely.
+ * The file is rewound before returning, so the caller can then read it from the start.
+ * Returns fallback if the file can not be sampled, for example when reading from a pipe.
+ *
+ * @param fp the file to sample
+ * @param fallback the value to return if the file can not be sampled
+ * @return the estimated number of distinct words
+ * @timeComplexity O(1), as at most REGIONS * REGION_SIZE bytes are read
+ */
+int estimateWords(FILE* fp, int fallback) {
+    assert(fp != NULL);
+    if (fseek(fp, 0, SEEK_END) != 0)
+        return fallback;
+    long size = ftell(fp);
+    if (size < 0)
+        return fallback;
+    unsigned char registers[REGISTERS] = {0};
+    char* buffer = malloc(REGION_SIZE);
+    assert(buffer != NULL);
+    long sampled = 0;
+    int regions = size <= (long) REGIONS * REGION_SIZE ? 1 : REGIONS;
+    int i = 0;
+    for (; i < regions; i++) {
+        long offset = regions == 1 ? 0 : (size - REGION_SIZE) / (REGIONS - 1) * i;
+        size_t n;
+        if (fseek(fp, offset, SEEK_SET) != 0)
+            break;
+        do {
+            n = fread(buffer, 1, REGION_SIZE, fp);
+            addWords(registers, buffer, n, offset == 0, offset + (long) n == size);
+            sampled += n;
+            offset += n;
+        } while (regions == 1 && n == REGION_SIZE); // a small file is read to the end
+    }
+    free(buffer);
+    rewind(fp);
+    if (sampled == 0)
+        return fallback;
+    double estimate = countSketch(registers);
+    if (sampled < size)
+        estimate *= pow((double) size / sampled, HEAPS_BETA);
+    if (estimate > size / 2 + 1)
+        estimate = size / 2 + 1; // every word needs at least one character and one space
+    return (int) estimate + 1;
+}
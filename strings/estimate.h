@@ -0,0 +1,17 @@
+/*
+ * File:        estimate.h
+ *
+ * Description: This file contains the public function declarations for
+ *              estimating the number of distinct words in a file without
+ *              reading all of it, so that a set can be created at the
+ *              right size.
+ */
+
+# ifndef ESTIMATE_H
+# define ESTIMATE_H
+
+# include <stdio.h>
+
+int estimateWords(FILE *fp, int fallback);
+
+# endif /* ESTIMATE_H */
@@ -15,7 +15,9 @@
 # include <stdio.h>
 # include <stdlib.h>
 # include <string.h>
+# include <stdbool.h>
 # include "set.h"
+# include "estimate.h"
 
 
 /* This is sufficient for the test cases in /scratch/coen12. */
@@ -36,13 +38,22 @@ int main(int argc, char *argv[])
     FILE *fp;
     char buffer[BUFSIZ];
     SET *odd;
-    int words;
+    int i, words, size;
+    bool sflag = false;
 
 
     /* Check usage and open the file. */
 
+    if (argc > 1 && strcmp(argv[1], "-s") == 0) {
+	sflag = true;
+	argc --;
+
+	for (i = 1; i < argc; i ++)
+	    argv[i] = argv[i + 1];
+    }
+
     if (argc != 2) {
-        fprintf(stderr, "usage: %s file1\n", argv[0]);
+        fprintf(stderr, "usage: %s [-s] file1\n", argv[0]);
         exit(EXIT_FAILURE);
     }
 
@@ -52,10 +63,16 @@ int main(int argc, char *argv[])
     }
 
 
+    /* Size the set from a sample of the file if desired. */
+
+    size = sflag ? estimateWords(fp, MAX_SIZE) * 4 / 3 + 1 : MAX_SIZE;
+
+
     /* Insert or delete words to compute their parity. */
 
     words = 0;
-    odd = createSet(MAX_SIZE);
+    odd = createSet(size);
+    setAutoShrink(odd, true);
 
     while (fscanf(fp, "%s", buffer) == 1) {
         words ++;
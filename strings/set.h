@@ -11,15 +11,26 @@
 # ifndef SET_H
 # define SET_H
 
+# include <stddef.h>
+# include <stdbool.h>
+
 typedef struct set SET;
 
+struct set_allocator {
+    void *(*allocate)(size_t size, void *context);
+    void (*release)(void *ptr, size_t size, void *context);
+    void *context;
+};
+
 SET *createSet(int maxElts);
 
+SET *createSetWithAllocator(int maxElts, const struct set_allocator *allocator);
+
 void destroySet(SET *sp);
 
 int numElements(SET *sp);
 
-void addElement(SET *sp, char *elt);
+bool addElement(SET *sp, char *elt);
 
 void removeElement(SET *sp, char *elt);
 
@@ -27,4 +38,22 @@ char *findElement(SET *sp, char *elt);
 
 char **getElements(SET *sp);
 
+void reserveSet(SET *sp, int n);
+
+void shrinkSet(SET *sp);
+
+void setAutoShrink(SET *sp, bool enabled);
+
+void setCapacity(SET *sp, int maxElts);
+
+void setHugePageThreshold(SET *sp, size_t bytes);
+
+void setThreads(SET *sp, int threads);
+
+SET *unionSets(SET *sp1, SET *sp2, bool inPlace);
+
+SET *intersectSets(SET *sp1, SET *sp2, bool inPlace);
+
+SET *differenceSets(SET *sp1, SET *sp2, bool inPlace);
+
 # endif /* SET_H */
@@ -0,0 +1,447 @@
+/*
+ * File:        setload.c
+ *
+ * Description: This file contains the main function for measuring the set
+ *              server with a load of lookups and adds from local clients.
+ *
+ *              The program takes the path of the server's socket, the name
+ *              of a set, and a file of words as command line arguments.
+ *              Each client (-c) connects to the server and sends requests
+ *              (-n) of a batch of words (-b) drawn at random from the
+ *              file, which are adds with the given percentage (-w) and
+ *              lookups otherwise.  A client keeps up to the given number
+ *              of requests (-p) in flight before it waits for a reply.
+ *              The throughput, the fraction of words found or already
+ *              present, and the latency of the requests are printed.
+ */
+
+# include <stdio.h>
+# include <stdlib.h>
+# include <string.h>
+# include <stdbool.h>
+# include <stdint.h>
+# include <time.h>
+# include <unistd.h>
+# include <pthread.h>
+# include <sys/socket.h>
+# include <sys/un.h>
+# include "setproto.h"
+
+
+# define DEFAULT_CLIENTS 4
+# define DEFAULT_BATCH 16
+# define DEFAULT_REQUESTS 100000
+# define DEFAULT_PIPELINE 1
+
+
+/* The settings shared by the clients, and the words they draw from. */
+
+static char *path, *name, **words;
+
+static int numWords, batch, requests, pipeline, writes;
+
+
+/* What a client measured: the latency of each request and the number of
+   words found, or already present when added. */
+
+struct client {
+    int index;
+    double *latency;
+    long hits;
+    bool failed;
+};
+
+
+/*
+ * Function:    seconds
+ *
+ * Description: Return the current time in seconds.
+ */
+
+static double seconds(void)
+{
+    struct timespec ts;
+
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+/*
+ * Function:    nextRandom
+ *
+ * Description: Return the next number from the xorshift generator whose
+ *              state is STATE.
+ */
+
+static uint64_t nextRandom(uint64_t *state)
+{
+    uint64_t x = *state;
+
+
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+
+/*
+ * Function:    connectServer
+ *
+ * Description: Return a socket connected to the server, or -1.
+ */
+
+static int connectServer(void)
+{
+    struct sockaddr_un address;
+    int fd;
+
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, path, sizeof(address.sun_path) - 1);
+
+    if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0)
+	return -1;
+
+    if (connect(fd, (struct sockaddr *) &address, sizeof(address)) < 0) {
+	close(fd);
+	return -1;
+    }
+
+    return fd;
+}
+
+
+/*
+ * Function:    transfer
+ *
+ * Description: Send or receive exactly N bytes at BUFFER on the socket FD.
+ *		Return false if the connection fails first.
+ */
+
+static bool transfer(int fd, void *buffer, size_t n, bool sending)
+{
+    ssize_t done;
+
+
+    while (n > 0) {
+	done = sending ? send(fd, buffer, n, MSG_NOSIGNAL) : recv(fd, buffer, n, 0);
+
+	if (done <= 0)
+	    return false;
+
+	buffer = (char *) buffer + done;
+	n -= done;
+    }
+
+    return true;
+}
+
+
+/*
+ * Function:    sendRequest
+ *
+ * Description: Send a request with op OP for COUNT words of the set, drawn
+ *		at random with the generator whose state is STATE, on the
+ *		socket FD using BUFFER.
+ */
+
+static bool sendRequest(int fd, int op, int count, char *buffer, uint64_t *state)
+{
+    struct set_request request;
+    size_t length;
+    char *word;
+    int i;
+
+
+    length = sizeof(request);
+    strcpy(buffer + length, name);
+    length += strlen(name) + 1;
+
+    for (i = 0; i < count; i ++) {
+	word = words[nextRandom(state) % numWords];
+	strcpy(buffer + length, word);
+	length += strlen(word) + 1;
+    }
+
+    request.length = length - sizeof(request);
+    request.op = op;
+    request.unused = 0;
+    request.count = count;
+    memcpy(buffer, &request, sizeof(request));
+    return transfer(fd, buffer, length, true);
+}
+
+
+/*
+ * Function:    receiveReply
+ *
+ * Description: Receive a reply on the socket FD into BUFFER and return
+ *		the number of its bytes that are 1, or -1 if it is not a
+ *		successful reply of LENGTH bytes.
+ */
+
+static long receiveReply(int fd, char *buffer, size_t length)
+{
+    struct set_reply reply;
+    long ones;
+    int i;
+
+
+    if (!transfer(fd, &reply, sizeof(reply), false))
+	return -1;
+
+    if (reply.status != SET_OK || reply.length != length || !transfer(fd, buffer, length, false))
+	return -1;
+
+    for (ones = 0, i = 0; i < length; i ++)
+	ones += buffer[i] == 1;
+
+    return ones;
+}
+
+
+/*
+ * Function:    runClient
+ *
+ * Description: Send the requests of the client at ARG, keeping up to
+ *		PIPELINE of them in flight, and record their latencies.
+ */
+
+static void *runClient(void *arg)
+{
+    struct client *cp = arg;
+    uint64_t state;
+    double *sent;
+    char *buffer;
+    long found;
+    int fd, i, done, op;
+
+
+    cp->failed = true;
+    state = 88172645463325252ull + 2654435761u * (cp->index + 1);
+    sent = malloc(pipeline * sizeof(double));
+    buffer = malloc(sizeof(struct set_request) + SET_MAX_REQUEST);
+
+    if (sent == NULL || buffer == NULL || (fd = connectServer()) < 0) {
+	free(sent);
+	free(buffer);
+	return NULL;
+    }
+
+    for (i = 0, done = 0; done < requests; ) {
+	if (i < requests && i - done < pipeline) {
+	    op = nextRandom(&state) % 100 < writes ? SET_ADD : SET_LOOKUP;
+	    sent[i % pipeline] = seconds();
+
+	    if (!sendRequest(fd, op, batch, buffer, &state))
+		break;
+
+	    i ++;
+	    continue;
+	}
+
+	if ((found = receiveReply(fd, buffer, batch)) < 0)
+	    break;
+
+	cp->latency[done] = seconds() - sent[done % pipeline];
+	cp->hits += found;
+	done ++;
+    }
+
+    cp->failed = done < requests;
+    close(fd);
+    free(sent);
+    free(buffer);
+    return NULL;
+}
+
+
+/*
+ * Function:    compareDoubles
+ *
+ * Description: Compare two doubles for qsort.
+ */
+
+static int compareDoubles(const void *p1, const void *p2)
+{
+    double x = *(const double *) p1, y = *(const double *) p2;
+
+
+    return x < y ? -1 : x > y;
+}
+
+
+/*
+ * Function:    countSet
+ *
+ * Description: Return the number of words in the set, or -1 if it cannot
+ *		be asked for.
+ */
+
+static long countSet(void)
+{
+    struct set_request request;
+    struct set_reply reply;
+    uint64_t total;
+    int fd;
+    bool ok;
+
+
+    if ((fd = connectServer()) < 0)
+	return -1;
+
+    request.length = strlen(name) + 1;
+    request.op = SET_COUNT;
+    request.unused = 0;
+    request.count = 0;
+
+    ok = transfer(fd, &request, sizeof(request), true) && transfer(fd, name, request.length, true)
+	&& transfer(fd, &reply, sizeof(reply), false) && reply.status == SET_OK
+	&& reply.length == sizeof(total) && transfer(fd, &total, sizeof(total), false);
+
+    close(fd);
+    return ok ? (long) total : -1;
+}
+
+
+/*
+ * Function:    main
+ *
+ * Description: Driver function for the load generator.
+ */
+
+int main(int argc, char *argv[])
+{
+    char buffer[BUFSIZ];
+    struct client *clients;
+    pthread_t *tids;
+    double start, elapsed, *latency;
+    long hits, total, size;
+    int i, j, n, numClients;
+    size_t longest;
+    FILE *fp;
+
+
+    /* Check usage and read the words. */
+
+    numClients = DEFAULT_CLIENTS;
+    batch = DEFAULT_BATCH;
+    requests = DEFAULT_REQUESTS;
+    pipeline = DEFAULT_PIPELINE;
+    writes = 0;
+
+    while (argc > 2 && argv[1][0] == '-' && strchr("cbnpw", argv[1][1]) != NULL && argv[1][2] == '\0') {
+	n = atoi(argv[2]);
+
+	if (argv[1][1] == 'c')
+	    numClients = n;
+	else if (argv[1][1] == 'b')
+	    batch = n;
+	else if (argv[1][1] == 'n')
+	    requests = n;
+	else if (argv[1][1] == 'p')
+	    pipeline = n;
+	else
+	    writes = n;
+
+	argc -= 2;
+
+	for (i = 1; i < argc; i ++)
+	    argv[i] = argv[i + 2];
+    }
+
+    if (argc != 4 || numClients < 1 || batch < 1 || batch > UINT16_MAX || requests < 1 || pipeline < 1 || writes < 0 || writes > 100) {
+	fprintf(stderr, "usage: %s [-c clients] [-b batch] [-n requests] [-p pipeline] [-w add%%] socket set file\n", argv[0]);
+	exit(EXIT_FAILURE);
+    }
+
+    path = argv[1];
+    name = argv[2];
+
+    if ((fp = fopen(argv[3], "r")) == NULL) {
+	fprintf(stderr, "%s: cannot open %s\n", argv[0], argv[3]);
+	exit(EXIT_FAILURE);
+    }
+
+    for (n = 0, longest = 0; fscanf(fp, "%s", buffer) == 1; numWords ++) {
+	if (numWords == n) {
+	    n = n > 0 ? n * 2 : 1024;
+	    words = realloc(words, n * sizeof(char *));
+	}
+
+	if (words == NULL || (words[numWords] = strdup(buffer)) == NULL) {
+	    fprintf(stderr, "%s: out of memory\n", argv[0]);
+	    exit(EXIT_FAILURE);
+	}
+
+	if (strlen(buffer) > longest)
+	    longest = strlen(buffer);
+    }
+
+    fclose(fp);
+
+    if (numWords == 0 || (size_t) batch * (longest + 1) + strlen(name) + 1 > SET_MAX_REQUEST) {
+	fprintf(stderr, "%s: no words in %s or batch too large\n", argv[0], argv[3]);
+	exit(EXIT_FAILURE);
+    }
+
+
+    /* Run the clients. */
+
+    clients = calloc(numClients, sizeof(struct client));
+    tids = malloc(numClients * sizeof(pthread_t));
+    latency = malloc((size_t) numClients * requests * sizeof(double));
+
+    if (clients == NULL || tids == NULL || latency == NULL) {
+	fprintf(stderr, "%s: out of memory\n", argv[0]);
+	exit(EXIT_FAILURE);
+    }
+
+    start = seconds();
+
+    for (i = 0; i < numClients; i ++) {
+	clients[i].index = i;
+	clients[i].latency = latency + (size_t) i * requests;
+	pthread_create(&tids[i], NULL, runClient, &clients[i]);
+    }
+
+    for (i = 0; i < numClients; i ++)
+	pthread_join(tids[i], NULL);
+
+    elapsed = seconds() - start;
+
+
+    /* Print the results. */
+
+    for (hits = 0, i = 0; i < numClients; i ++) {
+	if (clients[i].failed) {
+	    fprintf(stderr, "%s: request to %s failed\n", argv[0], path);
+	    exit(EXIT_FAILURE);
+	}
+
+	hits += clients[i].hits;
+    }
+
+    total = (long) numClients * requests;
+    qsort(latency, total, sizeof(double), compareDoubles);
+    size = countSet();
+
+    printf("%d clients, %d requests of %d words, pipeline %d, %d%% adds\n", numClients, requests, batch, pipeline, writes);
+    printf("  %.0f requests/s  %.2f M words/s  %.2f%% hits  %ld words in set\n",
+	total / elapsed, total * batch / elapsed / 1e6, 100.0 * hits / total / batch, size);
+    printf("  latency us: p50 %.1f  p99 %.1f  p99.9 %.1f  max %.1f\n",
+	latency[total / 2] * 1e6, latency[total * 99 / 100] * 1e6, latency[total * 999 / 1000] * 1e6, latency[total - 1] * 1e6);
+
+    for (j = 0; j < numWords; j ++)
+	free(words[j]);
+
+    free(words);
+    free(latency);
+    free(tids);
+    free(clients);
+    exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,56 @@
+/*
+ * File:        setproto.h
+ *
+ * Description: This file contains the declarations for the protocol
+ *              spoken over the Unix domain socket of the set server.
+ *
+ *              A request is a header followed by LENGTH bytes: the name
+ *              of a set and then COUNT words, each terminated by a null
+ *              character.  The reply is a header followed by LENGTH
+ *              bytes: for a lookup, add, or remove, one byte per word,
+ *              which is 1 if the word was found, added, or removed, and
+ *              for a count, the number of words in the set as a 64-bit
+ *              integer.  A client may send several requests before
+ *              reading the replies, which come back in the same order.
+ *              Since both ends are on the same machine, integers are in
+ *              its own byte order.
+ */
+
+# ifndef SETPROTO_H
+# define SETPROTO_H
+
+# include <stdint.h>
+
+
+/* The requests, and the status of a reply. */
+
+# define SET_LOOKUP 1
+# define SET_ADD 2
+# define SET_REMOVE 3
+# define SET_COUNT 4
+
+# define SET_OK 0
+# define SET_NO_SET 1
+# define SET_BAD_REQUEST 2
+
+
+/* A request may not be longer than this, and a connection sending one
+   is closed. */
+
+# define SET_MAX_REQUEST (1 << 20)
+
+struct set_request {
+    uint32_t length;
+    uint8_t op;
+    uint8_t unused;
+    uint16_t count;
+};
+
+struct set_reply {
+    uint32_t length;
+    uint8_t status;
+    uint8_t unused;
+    uint16_t count;
+};
+
+# endif /* SETPROTO_H */
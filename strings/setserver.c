@@ -0,0 +1,581 @@
+/*
+ * File:        setserver.c
+ *
+ * Description: This file contains the main function for a server that
+ *              answers membership queries about sets of strings over a
+ *              Unix domain socket, so a program can look up words without
+ *              starting a process or building a set of its own.
+ *
+ *              The program takes the path of the socket and one or more
+ *              sets as command line arguments, each given as NAME=FILE,
+ *              and the words of each file are loaded into a set of that
+ *              name; the list printed by unique -l can be used as a
+ *              snapshot of a set.  Requests for a set, as described in
+ *              setproto.h, look up, add, or remove a batch of words, or
+ *              count the words in the set.
+ *
+ *              The main thread accepts connections and hands them out in
+ *              turn to the worker threads, one per processor unless -j is
+ *              given.  Each worker waits on its own connections with
+ *              epoll and answers every complete request it has read, so
+ *              a client can send many requests at once.  Lookups and
+ *              counts of a set may run at the same time in several
+ *              workers, while adds and removes have the set to themselves.
+ */
+
+# define _GNU_SOURCE
+# include <stdio.h>
+# include <stdlib.h>
+# include <string.h>
+# include <ctype.h>
+# include <stdbool.h>
+# include <stdint.h>
+# include <errno.h>
+# include <unistd.h>
+# include <pthread.h>
+# include <sys/socket.h>
+# include <sys/un.h>
+# include <sys/epoll.h>
+# include "set.h"
+# include "estimate.h"
+# include "setproto.h"
+
+
+/* This is sufficient for the test cases in /scratch/coen12. */
+
+# define MAX_SIZE 18000
+
+
+/* Longer words in a file being loaded are skipped, and the conversion
+   that reads a word must stop at this length. */
+
+# define MAX_WORD 8191
+# define WORD_FORMAT "%8191s"
+
+
+/* A worker waits for at most this many connections at once. */
+
+# define MAX_EVENTS 64
+
+
+/* A worker stops reading from a connection whose replies have not been
+   read once they reach this many bytes. */
+
+# define MAX_PENDING (4 << 20)
+
+
+/* A set, its name, and the lock taken to use it. */
+
+struct named {
+    char *name;
+    SET *sp;
+    pthread_rwlock_t lock;
+};
+
+static struct named *sets;
+
+static int numSets;
+
+
+/* A connection, with the bytes read from it that do not yet make up a
+   whole request, the replies not yet written to it, and whether the
+   client has finished sending. */
+
+struct connection {
+    int fd;
+    char *in, *out;
+    size_t inLength, inSize;
+    size_t outStart, outLength, outSize;
+    uint32_t events;
+    bool eof;
+};
+
+
+/*
+ * Function:    loadSet
+ *
+ * Description: Read the words of the file named PATH into a new set named
+ *		NAME at NP, and store the number of words skipped for being
+ *		longer than MAX_WORD in SKIPPED.  Return false if the file
+ *		cannot be read.
+ */
+
+static bool loadSet(struct named *np, char *name, char *path, long *skipped)
+{
+    char buffer[MAX_WORD + 1];
+    FILE *fp;
+    int c;
+
+
+    if ((fp = fopen(path, "r")) == NULL)
+	return false;
+
+    np->name = name;
+    np->sp = createSet(estimateWords(fp, MAX_SIZE) * 4 / 3 + 1);
+    pthread_rwlock_init(&np->lock, NULL);
+    *skipped = 0;
+
+    while (fscanf(fp, WORD_FORMAT, buffer) == 1) {
+	if (strlen(buffer) == MAX_WORD && (c = getc(fp)) != EOF && !isspace(c)) {
+	    while ((c = getc(fp)) != EOF && !isspace(c))
+		;
+
+	    (*skipped) ++;
+	    continue;
+	}
+
+	addElement(np->sp, buffer);
+    }
+
+    fclose(fp);
+    return true;
+}
+
+
+/*
+ * Function:    findSet
+ *
+ * Description: Return the set named NAME, or NULL if there is none.
+ */
+
+static struct named *findSet(char *name)
+{
+    int i;
+
+
+    for (i = 0; i < numSets; i ++)
+	if (strcmp(sets[i].name, name) == 0)
+	    return &sets[i];
+
+    return NULL;
+}
+
+
+/*
+ * Function:    reserveOutput
+ *
+ * Description: Return space for N more bytes of replies to the connection
+ *		CP, moving the unwritten replies to the front of the buffer
+ *		or growing it as needed.
+ */
+
+static char *reserveOutput(struct connection *cp, size_t n)
+{
+    char *space;
+
+
+    if (cp->outStart > 0) {
+	memmove(cp->out, cp->out + cp->outStart, cp->outLength - cp->outStart);
+	cp->outLength -= cp->outStart;
+	cp->outStart = 0;
+    }
+
+    if (cp->outLength + n > cp->outSize) {
+	while (cp->outLength + n > cp->outSize)
+	    cp->outSize = cp->outSize > 0 ? cp->outSize * 2 : BUFSIZ;
+
+	cp->out = realloc(cp->out, cp->outSize);
+
+	if (cp->out == NULL) {
+	    fprintf(stderr, "out of memory\n");
+	    exit(EXIT_FAILURE);
+	}
+    }
+
+    space = cp->out + cp->outLength;
+    cp->outLength += n;
+    return space;
+}
+
+
+/*
+ * Function:    answerRequest
+ *
+ * Description: Answer the request RP whose words are in BODY, adding the
+ *		reply to the output of the connection CP.
+ */
+
+static void answerRequest(struct connection *cp, struct set_request *rp, char *body)
+{
+    struct set_reply reply;
+    struct named *np;
+    char *p, *end, *name, *result;
+    uint64_t total;
+    int i;
+
+
+    /* Check that the body is a name followed by COUNT words. */
+
+    reply.length = 0;
+    reply.status = SET_OK;
+    reply.unused = 0;
+    reply.count = rp->count;
+
+    p = body;
+    end = body + rp->length;
+
+    if (rp->length == 0 || end[-1] != '\0')
+	reply.status = SET_BAD_REQUEST;
+    else {
+	name = p;
+	p += strlen(p) + 1;
+
+	for (i = 0; i < rp->count && p < end; i ++)
+	    p += strlen(p) + 1;
+
+	if (i < rp->count || p != end || rp->op < SET_LOOKUP || rp->op > SET_COUNT || (rp->op == SET_COUNT && rp->count != 0))
+	    reply.status = SET_BAD_REQUEST;
+	else if ((np = findSet(name)) == NULL)
+	    reply.status = SET_NO_SET;
+    }
+
+    if (reply.status != SET_OK) {
+	reply.count = 0;
+	memcpy(reserveOutput(cp, sizeof(reply)), &reply, sizeof(reply));
+	return;
+    }
+
+
+    /* Answer the request, with the words starting after the name. */
+
+    p = body + strlen(body) + 1;
+    reply.length = rp->op == SET_COUNT ? sizeof(total) : rp->count;
+    memcpy(reserveOutput(cp, sizeof(reply)), &reply, sizeof(reply));
+    result = reserveOutput(cp, reply.length);
+
+    if (rp->op == SET_LOOKUP || rp->op == SET_COUNT)
+	pthread_rwlock_rdlock(&np->lock);
+    else
+	pthread_rwlock_wrlock(&np->lock);
+
+    if (rp->op == SET_COUNT) {
+	total = numElements(np->sp);
+	memcpy(result, &total, sizeof(total));
+    }
+
+    for (i = 0; i < rp->count; i ++) {
+	if (rp->op == SET_LOOKUP)
+	    result[i] = findElement(np->sp, p) != NULL;
+	else if (rp->op == SET_ADD)
+	    result[i] = addElement(np->sp, p);
+	else if ((result[i] = findElement(np->sp, p) != NULL))
+	    removeElement(np->sp, p);
+
+	p += strlen(p) + 1;
+    }
+
+    pthread_rwlock_unlock(&np->lock);
+}
+
+
+/*
+ * Function:    answerRequests
+ *
+ * Description: Answer every whole request read from the connection CP,
+ *		stopping early if too many replies are waiting to be
+ *		written.  Return the number of requests answered, or -1 if
+ *		a request is too long.
+ */
+
+static int answerRequests(struct connection *cp)
+{
+    struct set_request request;
+    size_t offset;
+    int answered;
+
+
+    offset = answered = 0;
+
+    while (cp->inLength - offset >= sizeof(request) && cp->outLength - cp->outStart < MAX_PENDING) {
+	memcpy(&request, cp->in + offset, sizeof(request));
+
+	if (request.length > SET_MAX_REQUEST)
+	    return -1;
+
+	if (cp->inLength - offset < sizeof(request) + request.length)
+	    break;
+
+	answerRequest(cp, &request, cp->in + offset + sizeof(request));
+	offset += sizeof(request) + request.length;
+	answered ++;
+    }
+
+    memmove(cp->in, cp->in + offset, cp->inLength - offset);
+    cp->inLength -= offset;
+    return answered;
+}
+
+
+/*
+ * Function:    readConnection
+ *
+ * Description: Read everything available from the connection CP, noting
+ *		when the client has finished sending.  Return false if it
+ *		cannot be read.
+ */
+
+static bool readConnection(struct connection *cp)
+{
+    ssize_t n;
+
+
+    for (;;) {
+	if (cp->inLength == cp->inSize) {
+	    if (cp->inSize >= 2 * (sizeof(struct set_request) + SET_MAX_REQUEST))
+		return true;
+
+	    cp->inSize = cp->inSize > 0 ? cp->inSize * 2 : BUFSIZ;
+	    cp->in = realloc(cp->in, cp->inSize);
+
+	    if (cp->in == NULL) {
+		fprintf(stderr, "out of memory\n");
+		exit(EXIT_FAILURE);
+	    }
+	}
+
+	n = read(cp->fd, cp->in + cp->inLength, cp->inSize - cp->inLength);
+
+	if (n > 0)
+	    cp->inLength += n;
+	else if (n == 0) {
+	    cp->eof = true;
+	    return true;
+	} else if (errno != EINTR)
+	    return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+}
+
+
+/*
+ * Function:    writeConnection
+ *
+ * Description: Write as many of the waiting replies to the connection CP
+ *		as it will take.  Return false if it cannot be written.
+ */
+
+static bool writeConnection(struct connection *cp)
+{
+    ssize_t n;
+
+
+    while (cp->outStart < cp->outLength) {
+	n = send(cp->fd, cp->out + cp->outStart, cp->outLength - cp->outStart, MSG_NOSIGNAL);
+
+	if (n > 0)
+	    cp->outStart += n;
+	else if (n < 0 && errno == EINTR)
+	    continue;
+	else
+	    return n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+    }
+
+    cp->outStart = cp->outLength = 0;
+    return true;
+}
+
+
+/*
+ * Function:    closeConnection
+ *
+ * Description: Close the connection CP and deallocate it.
+ */
+
+static void closeConnection(struct connection *cp)
+{
+    close(cp->fd);
+    free(cp->in);
+    free(cp->out);
+    free(cp);
+}
+
+
+/*
+ * Function:    serve
+ *
+ * Description: Answer the requests of the connections registered with
+ *		the epoll instance whose descriptor EPFD points to, waiting
+ *		to read from a connection unless too many of its replies
+ *		are waiting, and to write to it while any are.  Once the
+ *		client has finished sending, the requests it sent are still
+ *		answered, and the connection is closed when every reply has
+ *		been written.
+ */
+
+static void *serve(void *epfd)
+{
+    struct epoll_event events[MAX_EVENTS], event;
+    struct connection *cp;
+    int i, n, answered;
+    bool ok;
+
+
+    for (;;) {
+	n = epoll_wait(*(int *) epfd, events, MAX_EVENTS, -1);
+
+	for (i = 0; i < n; i ++) {
+	    cp = events[i].data.ptr;
+
+	    if (!cp->eof && (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)))
+		if (!readConnection(cp)) {
+		    closeConnection(cp);
+		    continue;
+		}
+
+	    /* Requests left unanswered while the replies were waiting are
+	       answered once they have all been written. */
+
+	    do
+		ok = (answered = answerRequests(cp)) >= 0 && writeConnection(cp);
+	    while (ok && answered > 0 && cp->outLength == 0);
+
+	    if (!ok || (cp->eof && cp->outLength == 0)) {
+		closeConnection(cp);
+		continue;
+	    }
+
+	    event.events = 0;
+
+	    if (!cp->eof && cp->outLength - cp->outStart < MAX_PENDING)
+		event.events |= EPOLLIN;
+
+	    if (cp->outStart < cp->outLength)
+		event.events |= EPOLLOUT;
+
+	    if (event.events != cp->events) {
+		event.data.ptr = cp;
+		cp->events = event.events;
+		epoll_ctl(*(int *) epfd, EPOLL_CTL_MOD, cp->fd, &event);
+	    }
+	}
+    }
+
+    return NULL;
+}
+
+
+/*
+ * Function:    main
+ *
+ * Description: Driver function for the server.
+ */
+
+int main(int argc, char *argv[])
+{
+    struct sockaddr_un address;
+    struct epoll_event event;
+    struct connection *cp;
+    pthread_t tid;
+    int i, fd, listener, next, threads, *epfds;
+    char *equals;
+    long skipped;
+
+
+    /* Check usage. */
+
+    threads = sysconf(_SC_NPROCESSORS_ONLN);
+
+    if (argc > 2 && strcmp(argv[1], "-j") == 0) {
+	threads = atoi(argv[2]);
+	argc -= 2;
+
+	for (i = 1; i < argc; i ++)
+	    argv[i] = argv[i + 2];
+    }
+
+    if (argc < 3 || threads < 1 || strlen(argv[1]) >= sizeof(address.sun_path)) {
+	fprintf(stderr, "usage: %s [-j threads] socket name=file [name=file ...]\n", argv[0]);
+	exit(EXIT_FAILURE);
+    }
+
+
+    /* Load the sets. */
+
+    numSets = argc - 2;
+    sets = malloc(numSets * sizeof(struct named));
+
+    if (sets == NULL) {
+	fprintf(stderr, "%s: out of memory\n", argv[0]);
+	exit(EXIT_FAILURE);
+    }
+
+    for (i = 0; i < numSets; i ++) {
+	if ((equals = strchr(argv[i + 2], '=')) == NULL || equals == argv[i + 2]) {
+	    fprintf(stderr, "%s: %s is not name=file\n", argv[0], argv[i + 2]);
+	    exit(EXIT_FAILURE);
+	}
+
+	*equals = '\0';
+
+	if (!loadSet(&sets[i], argv[i + 2], equals + 1, &skipped)) {
+	    fprintf(stderr, "%s: cannot open %s\n", argv[0], equals + 1);
+	    exit(EXIT_FAILURE);
+	}
+
+	if (skipped > 0)
+	    fprintf(stderr, "%s: skipped %ld words longer than %d bytes in %s\n", argv[0], skipped, MAX_WORD, equals + 1);
+
+	printf("%s: %d words\n", sets[i].name, numElements(sets[i].sp));
+    }
+
+
+    /* Listen on the socket. */
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, argv[1]);
+    unlink(argv[1]);
+
+    listener = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (listener < 0 || bind(listener, (struct sockaddr *) &address, sizeof(address)) < 0 || listen(listener, SOMAXCONN) < 0) {
+	fprintf(stderr, "%s: cannot listen on %s\n", argv[0], argv[1]);
+	exit(EXIT_FAILURE);
+    }
+
+
+    /* Start the workers and hand each new connection to the next one. */
+
+    epfds = malloc(threads * sizeof(int));
+
+    if (epfds == NULL) {
+	fprintf(stderr, "%s: out of memory\n", argv[0]);
+	exit(EXIT_FAILURE);
+    }
+
+    for (i = 0; i < threads; i ++) {
+	if ((epfds[i] = epoll_create1(0)) < 0 || pthread_create(&tid, NULL, serve, &epfds[i]) != 0) {
+	    fprintf(stderr, "%s: cannot start worker\n", argv[0]);
+	    exit(EXIT_FAILURE);
+	}
+
+	pthread_detach(tid);
+    }
+
+    printf("listening on %s with %d workers\n", argv[1], threads);
+    fflush(stdout);
+
+    for (next = 0; ; next = (next + 1) % threads) {
+	if ((fd = accept4(listener, NULL, NULL, SOCK_NONBLOCK)) < 0) {
+	    if (errno == EINTR || errno == ECONNABORTED || errno == EMFILE || errno == ENFILE)
+		continue;
+
+	    fprintf(stderr, "%s: cannot accept connection\n", argv[0]);
+	    exit(EXIT_FAILURE);
+	}
+
+	cp = calloc(1, sizeof(struct connection));
+
+	if (cp == NULL) {
+	    close(fd);
+	    continue;
+	}
+
+	cp->fd = fd;
+	cp->events = EPOLLIN;
+	event.events = EPOLLIN;
+	event.data.ptr = cp;
+
+	if (epoll_ctl(epfds[next], EPOLL_CTL_ADD, fd, &event) < 0)
+	    closeConnection(cp);
+    }
+}
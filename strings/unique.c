@@ -6,12 +6,14 @@
  * Description: This file contains the main function for testing a set
  *              abstract data type for strings.
  *
- *              The program takes two files as command line arguments, the
- *              second of which is optional.  All words in the first file
- *              are inserted into the set and the counts of total words and
- *              total words in the set are printed.  If the second file is
- *              given then all words in the second file are deleted from
- *              the set and the count printed.
+ *              The program takes one or more files as command line
+ *              arguments.  All words in the first file are inserted into
+ *              the set and the counts of total words and total words in
+ *              the set are printed.  The words of each further file are
+ *              put in a set of their own and combined with the first set,
+ *              by default by deleting them from it (-d), or by keeping only
+ *              the words in both (-i), or by adding them (-u), and the
+ *              final count is printed.
  */
 
 # include <stdio.h>
@@ -19,6 +21,7 @@
 # include <string.h>
 # include <stdbool.h>
 # include "set.h"
+# include "estimate.h"
 
 
 /* This is sufficient for the test cases in /scratch/coen12. */
@@ -26,6 +29,33 @@
 # define MAX_SIZE 18000
 
 
+/*
+ * Function:	readWords
+ *
+ * Description:	Return a new set of the words in the file FP, and add the
+ *		number of words in the file to WORDS.  The set is sized
+ *		from a sample of the file if SFLAG is true.
+ */
+
+static SET *readWords(FILE *fp, bool sflag, int *words)
+{
+    char buffer[BUFSIZ];
+    SET *sp;
+    int size;
+
+
+    size = sflag ? estimateWords(fp, MAX_SIZE) * 4 / 3 + 1 : MAX_SIZE;
+    sp = createSet(size);
+
+    while (fscanf(fp, "%s", buffer) == 1) {
+	(*words) ++;
+	addElement(sp, buffer);
+    }
+
+    return sp;
+}
+
+
 /*
  * Function:    main
  *
@@ -35,24 +65,37 @@
 int main(int argc, char *argv[])
 {
     FILE *fp;
-    char buffer[BUFSIZ], **elts;
-    SET *unique;
-    int i, words;
-    bool lflag = false;
+    char **elts, op = 'd';
+    SET *unique, *other;
+    int i, words, threads = 1;
+    bool lflag = false, sflag = false;
 
 
     /* Check usage and open the first file. */
 
-    if (argc > 1 && strcmp(argv[1], "-l") == 0) {
-	lflag = true;
+    while (argc > 2 && argv[1][0] == '-' && strchr("lsuidt", argv[1][1]) && argv[1][2] == '\0') {
+	if (argv[1][1] == 'l')
+	    lflag = true;
+	else if (argv[1][1] == 's')
+	    sflag = true;
+	else if (argv[1][1] != 't')
+	    op = argv[1][1];
+	else if ((threads = atoi(argv[2])) > 0) {
+	    argc --;
+
+	    for (i = 1; i < argc; i ++)
+		argv[i] = argv[i + 1];
+	} else
+	    break;
+
 	argc --;
 
 	for (i = 1; i < argc; i ++)
 	    argv[i] = argv[i + 1];
     }
 
-    if (argc == 1 || argc > 3) {
-        fprintf(stderr, "usage: %s [-l] file1 [file2]\n", argv[0]);
+    if (argc == 1 || argv[1][0] == '-') {
+        fprintf(stderr, "usage: %s [-l] [-s] [-u | -i | -d] [-t threads] file1 [file2 ...]\n", argv[0]);
         exit(EXIT_FAILURE);
     }
 
@@ -65,13 +108,8 @@ int main(int argc, char *argv[])
     /* Insert all words into the set. */
 
     words = 0;
-    unique = createSet(MAX_SIZE);
-
-    while (fscanf(fp, "%s", buffer) == 1) {
-        words ++;
-        addElement(unique, buffer);
-    }
-
+    unique = readWords(fp, sflag, &words);
+    setThreads(unique, threads);
     fclose(fp);
 
     if (!lflag) {
@@ -80,24 +118,34 @@ int main(int argc, char *argv[])
     }
 
 
-    /* Try to open the second file. */
+    /* Combine the words of each further file with the set. */
 
-    if (argc == 3) {
-        if ((fp = fopen(argv[2], "r")) == NULL) {
-            fprintf(stderr, "%s: cannot open %s\n", argv[0], argv[2]);
-            exit(EXIT_FAILURE);
-        }
+    if (argc > 2) {
+	for (i = 2; i < argc; i ++) {
+	    if ((fp = fopen(argv[i], "r")) == NULL) {
+		fprintf(stderr, "%s: cannot open %s\n", argv[0], argv[i]);
+		exit(EXIT_FAILURE);
+	    }
 
+	    words = 0;
+	    other = readWords(fp, sflag, &words);
+	    fclose(fp);
 
-        /* Delete all words in the second file. */
+	    if (op == 'u')
+		unionSets(unique, other, true);
+	    else if (op == 'i')
+		intersectSets(unique, other, true);
+	    else
+		differenceSets(unique, other, true);
 
-        while (fscanf(fp, "%s", buffer) == 1)
-            removeElement(unique, buffer);
+	    destroySet(other);
+	}
 
-	fclose(fp);
+	shrinkSet(unique);
 
 	if (!lflag)
-	    printf("%d remaining words\n", numElements(unique));
+	    printf("%d %s words\n", numElements(unique),
+		op == 'u' ? "combined" : op == 'i' ? "common" : "remaining");
     }
 
 